@@ -0,0 +1,99 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __ACTIVITY_MANAGER_HPP__
+#define __ACTIVITY_MANAGER_HPP__
+
+
+#include <set>
+#include <vector>
+#include "definitions.hpp"
+#include "Entity.hpp"
+#include "TransformStore.hpp"
+#include "WorldSpace.hpp"
+#include "renderer/Camera.hpp"
+
+
+namespace Dodge {
+
+
+// Splits a set of entities into 'active' and 'dormant' according to their
+// distance from the camera.
+//
+// An entity becomes active once its boundary enters the camera's view,
+// expanded by the activation margin, and goes dormant again once it leaves
+// the view expanded by the (larger) deactivation margin. The gap between the
+// two stops entities on the edge from flickering between states.
+//
+// Candidates are found by querying WorldSpace, so managed entities should
+// also be tracked by WorldSpace. Active entities with a TransformStore slot
+// are checked against the deactivation region by reading their boundaries
+// from the store, so the check only touches an entity when it goes dormant.
+// Entity::setDormant() is called on each transition, which for physical
+// entities also sends the body to sleep. The game loop should update and
+// draw only getActiveEntities(), which are kept in order of their entity
+// handles so that the update and draw order doesn't depend on where the
+// entities were allocated.
+class ActivityManager {
+   public:
+      ActivityManager(float32_t activationMargin, float32_t deactivationMargin);
+
+      void addEntity(pEntity_t entity);
+      void removeEntity(pEntity_t entity);
+      void removeAll();
+
+      void update(const Camera& camera);
+
+      inline const std::vector<pEntity_t>& getActiveEntities() const;
+      inline const std::set<pEntity_t>& getDormantEntities() const;
+
+      inline void setMargins(float32_t activationMargin, float32_t deactivationMargin);
+
+   private:
+      static bool handleOrder(const pEntity_t& a, const pEntity_t& b);
+
+      std::vector<pEntity_t>::iterator findActive(const pEntity_t& entity);
+      void rebuildActiveIndices();
+
+      float32_t m_activationMargin;
+      float32_t m_deactivationMargin;
+
+      std::vector<pEntity_t> m_activeList; // Sorted by handle
+      std::vector<TransformStore::index_t> m_activeIdx; // Store slots of m_activeList
+      std::set<pEntity_t> m_dormant;
+      std::vector<pEntity_t> m_activated;
+      std::vector<pEntity_t> m_scratch;
+
+      WorldSpace m_worldSpace;
+      TransformStore m_transformStore;
+};
+
+//===========================================
+// ActivityManager::getActiveEntities
+//===========================================
+inline const std::vector<pEntity_t>& ActivityManager::getActiveEntities() const {
+   return m_activeList;
+}
+
+//===========================================
+// ActivityManager::getDormantEntities
+//===========================================
+inline const std::set<pEntity_t>& ActivityManager::getDormantEntities() const {
+   return m_dormant;
+}
+
+//===========================================
+// ActivityManager::setMargins
+//===========================================
+inline void ActivityManager::setMargins(float32_t activationMargin, float32_t deactivationMargin) {
+   m_activationMargin = activationMargin;
+   m_deactivationMargin = deactivationMargin;
+}
+
+
+}
+
+
+#endif /*!__ACTIVITY_MANAGER_HPP__*/
@@ -7,6 +7,7 @@
 #define __BOX_2D_PHYSICS_HPP__
 
 
+#include <mutex>
 #include "../Box2D/Box2D.h"
 #include "definitions.hpp"
 #include "EntityPhysics.hpp"
@@ -45,6 +46,7 @@ class Box2dPhysics : public EntityPhysics {
       virtual void applyForce(const Vec2f& force);
       virtual void makeDynamic();
       virtual void makeStatic();
+      virtual void setAwake(bool b);
 
       virtual void setLinearVelocity(const Vec2f& v);
       virtual Vec2f getLinearVelocity() const;
@@ -67,6 +69,7 @@ class Box2dPhysics : public EntityPhysics {
 
       static EventManager m_eventManager;
       static std::set<long> m_ignore;
+      static std::mutex m_ignoreMutex;
 
       static float32_t m_timeStep;
       static float32_t m_worldUnitsPerMetre;
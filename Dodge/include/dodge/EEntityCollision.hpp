@@ -9,22 +9,21 @@
 
 #include "StringId.hpp"
 #include "EEvent.hpp"
-#include <boost/shared_ptr.hpp>
+#include "EntityHandle.hpp"
 
 
 namespace Dodge {
 
 
-class Entity;
-
+// Entities are referred to by handle; resolve them with EntityRegistry.
 class EEntityCollision : public EEvent {
    public:
-      EEntityCollision(bool b, boost::shared_ptr<Entity> A, boost::shared_ptr<Entity> B)
+      EEntityCollision(bool b, const EntityHandle& A, const EntityHandle& B)
          : EEvent(internString("entityCollision")), incoming(b), entityA(A), entityB(B) {}
 
       bool incoming;
-      boost::shared_ptr<Entity> entityA;
-      boost::shared_ptr<Entity> entityB;
+      EntityHandle entityA;
+      EntityHandle entityB;
 };
 
 
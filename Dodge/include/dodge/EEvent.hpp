@@ -7,6 +7,8 @@
 #define __EEVENT_HPP__
 
 
+#include <mutex>
+#include <atomic>
 #include "definitions.hpp"
 #include "StackAllocator.hpp"
 
@@ -34,8 +36,9 @@ class EEvent {
    private:
       long m_type;
       long m_id;
-      static long m_nextId;
+      static std::atomic<long> m_nextId;
       static StackAllocator m_stack;
+      static std::mutex m_stackMutex;
 };
 
 //===========================================
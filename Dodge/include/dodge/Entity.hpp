@@ -14,6 +14,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <set>
+#include <vector>
 #include "definitions.hpp"
 #include "StringId.hpp"
 #include "EventManager.hpp"
@@ -22,6 +23,8 @@
 #include "renderer/Renderer.hpp"
 #include "xml/xml.hpp"
 #include "Asset.hpp"
+#include "TransformStore.hpp"
+#include "EntityHandle.hpp"
 
 
 namespace Dodge {
@@ -88,6 +91,32 @@ class EEntityRotation : public EEvent {
 };
 
 
+// Emitted once by Entity::translateMany in place of the per-entity bounding box
+// and translation events. Anything listening for queued entityTranslation or
+// entityBoundingBox events must also listen for this one, or it will miss
+// entities moved this way.
+class EEntityBatchTranslation : public EEvent {
+   public:
+      struct entry_t {
+         entry_t(pEntity_t entity_, const Range& oldBoundingBox_, const Range& newBoundingBox_,
+            const Vec2f& oldTransl_abs_, const Vec2f& newTransl_abs_)
+            : entity(entity_), oldBoundingBox(oldBoundingBox_), newBoundingBox(newBoundingBox_),
+              oldTransl_abs(oldTransl_abs_), newTransl_abs(newTransl_abs_) {}
+
+         pEntity_t entity;
+         Range oldBoundingBox;
+         Range newBoundingBox;
+         Vec2f oldTransl_abs;
+         Vec2f newTransl_abs;
+      };
+
+      EEntityBatchTranslation()
+         : EEvent(internString("entityBatchTranslation")) {}
+
+      std::vector<entry_t> entries;
+};
+
+
 class IAuxData {
    public:
       IAuxData() {}
@@ -135,6 +164,10 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
       virtual void setSilent(bool b);
       inline bool isSilent() const;
 
+      // Set by ActivityManager for entities outside the active region
+      virtual void setDormant(bool b);
+      inline bool isDormant() const;
+
       inline void attachAuxData(std::unique_ptr<IAuxData> data);
       inline IAuxData* getAuxDataPtr() const;
 
@@ -146,6 +179,13 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
       inline void setTranslation_y(float32_t y);
       virtual void translate(float32_t x, float32_t y);
       inline void translate(const Vec2f& t);
+
+      // No entityTranslation or entityBoundingBox events are queued for
+      // entities moved this way, so listeners for those miss the move unless
+      // they also handle the single EEntityBatchTranslation that is queued
+      static void translateMany(const std::vector<pEntity_t>& entities, const std::vector<Vec2f>& deltas);
+      static void translateMany(const std::vector<pEntity_t>& entities, const Vec2f& delta);
+
       inline void translate_x(float32_t x);
       inline void translate_y(float32_t y);
       virtual void setZ(float32_t z);
@@ -184,9 +224,17 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
       virtual Renderer::int_t getLineWidth() const;
 
       inline pEntity_t getSharedPtr();
+      inline const EntityHandle& getHandle() const;
+
+      // Slot in the transform store, or TransformStore::NULL_INDEX
+      inline TransformStore::index_t getTransformIndex() const;
 
       virtual void draw() const;
 
+      // Appends the models that draw() would draw, with their transforms up
+      // to date
+      virtual void getModels(std::vector<IModel*>& models) const;
+
       virtual void update() {}
 
 #ifdef DEBUG
@@ -197,10 +245,13 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
 
    protected:
       static EventManager m_eventManager;
+      static TransformStore m_transformStore;
 
    private:
       void rotateShapes_r(float32_t deg);
       void recomputeBoundary();
+      void syncTransformStore();
+      void translate_(const Vec2f& delta, EEntityBatchTranslation* batch);
       void deepCopy(const Entity& copy);
       void onParentTransformation(float32_t oldRot, const Vec2f& oldTransl);
 
@@ -209,6 +260,7 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
       long m_name;
       long m_type;
       bool m_silent; // If true, entity does not propagate any events
+      bool m_dormant;
       Vec2f m_scale;
 
       Vec2f m_transl;
@@ -225,6 +277,9 @@ class Entity : virtual public Asset, virtual public boost::enable_shared_from_th
       Entity* m_parent;
       std::set<pEntity_t> m_children;
 
+      TransformStore::index_t m_transformIdx;
+      EntityHandle m_handle;
+
       static int m_count;
       static long generateName();
 };
@@ -237,6 +292,20 @@ inline pEntity_t Entity::getSharedPtr() {
    return shared_from_this();
 }
 
+//===========================================
+// Entity::getHandle
+//===========================================
+inline const EntityHandle& Entity::getHandle() const {
+   return m_handle;
+}
+
+//===========================================
+// Entity::getTransformIndex
+//===========================================
+inline TransformStore::index_t Entity::getTransformIndex() const {
+   return m_transformIdx;
+}
+
 //===========================================
 // Entity::attachAuxData
 //===========================================
@@ -258,6 +327,13 @@ inline bool Entity::isSilent() const {
    return m_silent;
 }
 
+//===========================================
+// Entity::isDormant
+//===========================================
+inline bool Entity::isDormant() const {
+   return m_dormant;
+}
+
 //===========================================
 // Entity::getParent
 //===========================================
@@ -60,6 +60,7 @@ class EntityAnimations {
       virtual void removeFromWorld() {}
 
       virtual void draw() const;
+      virtual void getModels(std::vector<IModel*>& models) const;
 
       virtual void update();
 #ifdef DEBUG
@@ -74,6 +75,7 @@ class EntityAnimations {
 
    private:
       void updateModel();
+      void updateMatrix();
 
       Entity* m_entity;
       pTexture_t m_texture;
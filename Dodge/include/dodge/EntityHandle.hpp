@@ -0,0 +1,68 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __ENTITY_HANDLE_HPP__
+#define __ENTITY_HANDLE_HPP__
+
+
+#include "definitions.hpp"
+
+
+namespace Dodge {
+
+
+// Weak, copyable reference to an entity. Resolve with EntityRegistry; a
+// handle whose entity has been destroyed resolves to NULL.
+class EntityHandle {
+   public:
+      EntityHandle()
+         : index(0), generation(0) {}
+
+      EntityHandle(uint_t index_, uint_t generation_)
+         : index(index_), generation(generation_) {}
+
+      inline bool isNull() const;
+
+      inline bool operator==(const EntityHandle& rhs) const;
+      inline bool operator!=(const EntityHandle& rhs) const;
+      inline bool operator<(const EntityHandle& rhs) const;
+
+      uint_t index;
+      uint_t generation; // 0 is reserved for the null handle
+};
+
+//===========================================
+// EntityHandle::isNull
+//===========================================
+inline bool EntityHandle::isNull() const {
+   return generation == 0;
+}
+
+//===========================================
+// EntityHandle::operator==
+//===========================================
+inline bool EntityHandle::operator==(const EntityHandle& rhs) const {
+   return index == rhs.index && generation == rhs.generation;
+}
+
+//===========================================
+// EntityHandle::operator!=
+//===========================================
+inline bool EntityHandle::operator!=(const EntityHandle& rhs) const {
+   return !(*this == rhs);
+}
+
+//===========================================
+// EntityHandle::operator<
+//===========================================
+inline bool EntityHandle::operator<(const EntityHandle& rhs) const {
+   return index == rhs.index ? generation < rhs.generation : index < rhs.index;
+}
+
+
+}
+
+
+#endif /*!__ENTITY_HANDLE_HPP__*/
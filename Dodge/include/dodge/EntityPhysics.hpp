@@ -59,6 +59,7 @@ class EntityPhysics {
       virtual void applyForce(const Vec2f& force) = 0;
       virtual void makeDynamic() = 0;
       virtual void makeStatic() = 0;
+      virtual void setAwake(bool b) = 0;
       virtual void setLinearVelocity(const Vec2f& v) = 0;
       virtual Vec2f getLinearVelocity() const = 0;
 
@@ -0,0 +1,96 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __ENTITY_REGISTRY_HPP__
+#define __ENTITY_REGISTRY_HPP__
+
+
+#include <mutex>
+#include <atomic>
+#include "EntityHandle.hpp"
+#include "Entity.hpp"
+
+
+namespace Dodge {
+
+
+// Maps entity handles to live entities. Slots are allocated in fixed-size
+// chunks so that they never move, and each slot carries a generation count
+// that is bumped when its entity is destroyed, invalidating old handles. The
+// registry only indexes entities; they're still allocated individually and
+// owned by their shared pointers.
+//
+// Every entity registers itself on construction. Entities can't be created
+// from an update() or draw() that EntityScheduler is running in parallel, but
+// they may be destroyed from one, so a slot's entity and generation are
+// atomic. Once remove() has returned, the old handle resolves to NULL on every
+// thread. A handle doesn't keep its entity alive though: an entity that
+// another thread may destroy in the meantime mustn't be dereferenced.
+class EntityRegistry {
+   public:
+      EntityHandle add(Entity* entity);
+      void remove(const EntityHandle& handle);
+
+      inline Entity* getEntity(const EntityHandle& handle) const;
+      pEntity_t getSharedPtr(const EntityHandle& handle) const;
+      inline bool isValid(const EntityHandle& handle) const;
+
+      inline uint_t getNumEntities() const;
+
+   private:
+      static const uint_t CHUNK_SIZE = 256;
+      static const uint_t MAX_CHUNKS = 4096;
+      static const uint_t NULL_SLOT = 0xffffffff;
+
+      struct slot_t {
+         std::atomic<Entity*> entity;
+         std::atomic<uint_t> generation;
+         uint_t nextFree;
+      };
+
+      // None of these have destructors, so entities held in static containers
+      // can still deregister while the program exits
+      static slot_t* m_chunks[MAX_CHUNKS];
+      static uint_t m_freeHead;
+      static uint_t m_numSlots;
+      static uint_t m_numEntities;
+
+      // Guards the free list and counters
+      static std::mutex m_mutex;
+};
+
+//===========================================
+// EntityRegistry::getEntity
+//
+// Returns NULL if the handle is stale.
+//===========================================
+inline Entity* EntityRegistry::getEntity(const EntityHandle& handle) const {
+   if (handle.index >= m_numSlots) return NULL;
+
+   const slot_t& slot = m_chunks[handle.index / CHUNK_SIZE][handle.index % CHUNK_SIZE];
+
+   if (slot.generation.load(std::memory_order_acquire) != handle.generation) return NULL;
+   return slot.entity.load(std::memory_order_acquire);
+}
+
+//===========================================
+// EntityRegistry::isValid
+//===========================================
+inline bool EntityRegistry::isValid(const EntityHandle& handle) const {
+   return getEntity(handle) != NULL;
+}
+
+//===========================================
+// EntityRegistry::getNumEntities
+//===========================================
+inline uint_t EntityRegistry::getNumEntities() const {
+   return m_numEntities;
+}
+
+
+}
+
+
+#endif /*!__ENTITY_REGISTRY_HPP__*/
@@ -0,0 +1,142 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __ENTITY_SCHEDULER_HPP__
+#define __ENTITY_SCHEDULER_HPP__
+
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include "definitions.hpp"
+#include "Entity.hpp"
+#include "StackAllocator.hpp"
+#include "renderer/DrawList.hpp"
+
+
+namespace Dodge {
+
+
+// Runs Entity::update() and Entity::draw() across a pool of worker threads.
+//
+// Entities are grouped by their depth in the entity hierarchy and each group
+// is run to completion before the next, so a parent is always processed
+// before its children. Entities within a group must not touch each other's
+// state (other than via events).
+//
+// Events queued during update() are buffered per entity and appended to the
+// main queue afterwards in the order the entities were given, so the
+// resulting event order doesn't depend on thread timing. Each worker has its
+// own gGetMemStack().
+//
+// Box2D isn't thread-safe, so entities with physics bodies (or with
+// descendants that have them) are updated on the calling thread, after the
+// rest of their group. Entities can't be created while a group is being
+// processed in parallel, as that would grow the EntityRegistry and
+// TransformStore arrays under the other workers; EntityRegistry::add() and
+// TransformStore::allocate() throw if this is attempted, and
+// Box2dPhysics::updatePos() throws if it's reached from a worker.
+//
+// While an entity's draw() runs, Renderer::draw() is redirected into a
+// DrawList belonging to the entity's chunk, and the lists are submitted to the
+// Renderer in chunk order, so the frame is the same however the chunks were
+// scheduled. As the lists reference models rather than copying them, an
+// entity mustn't draw the same model twice with different state in one frame.
+class EntityScheduler {
+   public:
+      // If numThreads is 0, one thread per hardware core is used
+      explicit EntityScheduler(uint_t numThreads = 0);
+
+      void update(const std::vector<pEntity_t>& entities);
+      void draw(const std::vector<pEntity_t>& entities);
+
+      // Below this many entities, work is done serially on the calling thread
+      inline void setParallelThreshold(uint_t n);
+      inline uint_t getNumThreads() const;
+
+      static bool inParallelSection();
+
+      ~EntityScheduler();
+
+   private:
+      enum task_t { TASK_UPDATE, TASK_DRAW };
+
+      static const uint_t CHUNK_SIZE = 16;
+
+      EntityScheduler(const EntityScheduler&);
+      EntityScheduler& operator=(const EntityScheduler&);
+
+      void run(const std::vector<pEntity_t>& entities, task_t task);
+      void runLevel(uint_t l);
+      void buildLevels(const std::vector<pEntity_t>& entities, task_t task);
+      void processLevel();
+      void processSerial(const std::vector<uint_t>& level);
+      void prepareDrawLists(uint_t nChunks);
+      void submitDrawLists();
+      void clearDrawLists();
+      void mergeEvents(uint_t n);
+      void workerLoop(uint_t idx);
+
+      static bool hasPhysics(const Entity* entity);
+
+      uint_t m_threshold;
+
+      std::vector<std::thread*> m_threads;
+      std::vector<std::unique_ptr<StackAllocator> > m_stacks;
+
+      std::mutex m_mutex;
+      std::condition_variable m_cvStart;
+      std::condition_variable m_cvDone;
+      long m_batch;
+      uint_t m_busy;
+      bool m_running;
+      std::exception_ptr m_exception; // First exception thrown by a worker
+
+      // State of the level currently being processed
+      task_t m_task;
+      const std::vector<pEntity_t>* m_entities;
+      const std::vector<uint_t>* m_level;
+      std::atomic<uint_t> m_next;
+      uint_t m_firstChunk; // Index into m_chunkLists of the level's first chunk
+
+      std::vector<std::vector<uint_t> > m_levels;
+
+      // Entities in each level that must be processed on the calling thread
+      std::vector<std::vector<uint_t> > m_serialLevels;
+      std::vector<std::vector<EEvent*> > m_eventBuffers;
+
+      // Lists the Renderer has finished with are empty, and are reused
+      std::vector<std::unique_ptr<DrawList> > m_drawListPool;
+      std::vector<DrawList*> m_chunkLists;   // One per chunk of the current draw()
+      int m_nextOrder;
+
+      static EventManager m_eventManager;
+};
+
+//===========================================
+// EntityScheduler::setParallelThreshold
+//===========================================
+inline void EntityScheduler::setParallelThreshold(uint_t n) {
+   m_threshold = n;
+}
+
+//===========================================
+// EntityScheduler::getNumThreads
+//
+// Number of worker threads, not counting the calling thread.
+//===========================================
+inline uint_t EntityScheduler::getNumThreads() const {
+   return m_threads.size();
+}
+
+
+}
+
+
+#endif /*!__ENTITY_SCHEDULER_HPP__*/
@@ -9,6 +9,7 @@
 
 #include <queue>
 #include <map>
+#include <vector>
 #include "../utils/Functor.hpp"
 #include "EEvent.hpp"
 
@@ -25,16 +26,31 @@ class EventManager {
       void doEvents();
       void clear();
 
+      // While set, events queued from the calling thread are appended to
+      // queue instead of the main queue. Pass NULL to restore.
+      inline void redirectQueue(std::vector<EEvent*>* queue);
+
    private:
       static std::map<long, std::vector<Functor<void, TYPELIST_1(EEvent*)> > > m_callbacks;
       static std::queue<EEvent*> m_eventQueue;
+      static THREAD_LOCAL std::vector<EEvent*>* m_redirect;
 };
 
 //===========================================
 // EventManager::queueEvent
 //===========================================
 inline void EventManager::queueEvent(EEvent* event) {
-   m_eventQueue.push(event);
+   if (m_redirect)
+      m_redirect->push_back(event);
+   else
+      m_eventQueue.push(event);
+}
+
+//===========================================
+// EventManager::redirectQueue
+//===========================================
+inline void EventManager::redirectQueue(std::vector<EEvent*>* queue) {
+   m_redirect = queue;
 }
 
 //===========================================
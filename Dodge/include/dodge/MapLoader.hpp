@@ -11,12 +11,14 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <boost/shared_ptr.hpp>
 #include "../utils/Functor.hpp"
 #include "xml/xml.hpp"
 #include "AssetManager.hpp"
 #include "Range.hpp"
 #include "Exception.hpp"
 #include "math/Vec2i.hpp"
+#include "renderer/StaticGeometry.hpp"
 
 
 namespace Dodge {
@@ -25,6 +27,11 @@ namespace Dodge {
 // The user of this class should make sure to not hold onto any assets that belong to a segment,
 // as this would cause the asset to persist (due to boost::shared_ptr) and to later be reloaded,
 // thereby duplicating it. Erasing assets from the asset manager is safe, however.
+//
+// Entities marked as static in a segment's assets file (<asset assetId="..." static="true">)
+// are baked into static geometry when the segment is loaded, after which the renderer ignores
+// their models until the segment is unloaded. The baked geometry is drawn by draw(), so static
+// entities must not be moved, modified or deleted while their segment is loaded.
 class MapLoader {
    public:
       static MapLoader& getInstance() {
@@ -40,6 +47,7 @@ class MapLoader {
 
       void parseMapFile(const std::string& directory, const std::string& name);
       void update(const Vec2f& cameraPos);
+      void draw() const;
       void freeAllAssets();
 
       inline const Range& getMapBoundary() const;
@@ -58,6 +66,8 @@ class MapLoader {
 
          std::string filePath;
          std::vector<long> assetIds;
+         std::vector<long> staticAssetIds;
+         boost::shared_ptr<StaticGeometry> staticGeometry;
          bool loaded;
       };
 
@@ -107,6 +117,8 @@ class MapLoader {
       void loadMapSettings(const XmlNode data);
       void loadSegment(const Vec2i& indices);
       void unloadSegments();
+      void bakeStaticGeometry(mapSegment_t& segment);
+      void releaseStaticGeometry(mapSegment_t& segment);
       void loadAssets(const XmlNode data, mapSegment_t* segment);
       void parseAssetsFile_r(const std::string& path, mapSegment_t* segment);
 
@@ -0,0 +1,63 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __PAYLOAD_RING_HPP__
+#define __PAYLOAD_RING_HPP__
+
+
+#include <cstddef>
+#include <atomic>
+#include "definitions.hpp"
+
+
+namespace Dodge {
+
+
+// Circular byte buffer for variable-sized data that accompanies messages
+// sent through an SpscQueue. One thread allocates and another releases, in
+// the same order, without locking.
+//
+// alloc() gives back a marker for the end of each allocation. Once the
+// consumer has finished with an allocation it passes the marker to
+// release(), which frees it along with any earlier allocations.
+class PayloadRing {
+   public:
+      typedef size_t marker_t;
+
+      explicit PayloadRing(size_t size);
+
+      void* alloc(size_t size, marker_t& end);
+      void release(marker_t end);
+
+      inline size_t getSize() const;
+
+      ~PayloadRing();
+
+   private:
+      static const size_t ALIGNMENT = 16;
+
+      PayloadRing(const PayloadRing&);
+      PayloadRing& operator=(const PayloadRing&);
+
+      byte_t* m_data;
+      size_t m_size;
+
+      // Total bytes allocated and released; both increase indefinitely
+      std::atomic<size_t> m_head;
+      std::atomic<size_t> m_tail;
+};
+
+//===========================================
+// PayloadRing::getSize
+//===========================================
+inline size_t PayloadRing::getSize() const {
+   return m_size;
+}
+
+
+}
+
+
+#endif /*!__PAYLOAD_RING_HPP__*/
@@ -161,6 +161,14 @@ class PhysicalEntity : virtual public Entity, public T_PHYSICS {
          T_PHYSICS::removeFromWorld();
       }
 
+      //===========================================
+      // PhysicalEntity::setDormant
+      //===========================================
+      virtual void setDormant(bool b) {
+         Entity::setDormant(b);
+         T_PHYSICS::setAwake(!b);
+      }
+
       //===========================================
       // PhysicalEntity::update
       //===========================================
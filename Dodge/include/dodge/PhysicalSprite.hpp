@@ -165,6 +165,14 @@ class PhysicalSprite : public Sprite, public T_PHYSICS {
          T_PHYSICS::removeFromWorld();
       }
 
+      //===========================================
+      // PhysicalSprite::setDormant
+      //===========================================
+      virtual void setDormant(bool b) {
+         Sprite::setDormant(b);
+         T_PHYSICS::setAwake(!b);
+      }
+
       //===========================================
       // PhysicalSprite::update
       //===========================================
@@ -8,6 +8,7 @@
 
 
 #include <vector>
+#include <map>
 #include <memory>
 #include "Range.hpp"
 #include "definitions.hpp"
@@ -22,7 +23,7 @@ class Quadtree : public SpatialContainer<T> {
    public:
       class Entry {
          public:
-            Entry(T item_, const Range& rect_)
+            Entry(const T& item_, const Range& rect_)
                : item(item_), rect(rect_) {}
 /*
             static void* operator new(size_t size) {
@@ -56,17 +57,54 @@ class Quadtree : public SpatialContainer<T> {
       //===========================================
       // Quadtree::insert
       //===========================================
-      virtual bool insert(T item, const Range& boundingBox) {
+      virtual bool insert(const T& item, const Range& boundingBox) {
          return insert_r(item, boundingBox);
       }
 
       //===========================================
       // Quadtree::remove
       //===========================================
-      virtual bool remove(T item, const Range& boundingBox) {
+      virtual bool remove(const T& item, const Range& boundingBox) {
          return remove_r(item, boundingBox);
       }
 
+      //===========================================
+      // Quadtree::moveMany
+      //
+      // Only the part of the tree covering the old bounding boxes is visited.
+      // Entries that still belong to their node are updated in place and the
+      // rest are reinserted afterwards.
+      //===========================================
+      virtual void moveMany(const std::vector<T>& items, const std::vector<Range>& oldBoundingBoxes,
+         const std::vector<Range>& newBoundingBoxes) {
+
+         if (items.empty()) return;
+
+         // If an item appears more than once, its last move wins
+         std::map<T, uint_t> moves;
+
+         Vec2f min = oldBoundingBoxes[0].getPosition();
+         Vec2f max = min + oldBoundingBoxes[0].getSize();
+
+         for (uint_t i = 0; i < items.size(); ++i) {
+            moves[items[i]] = i;
+
+            const Vec2f& p = oldBoundingBoxes[i].getPosition();
+            Vec2f q = p + oldBoundingBoxes[i].getSize();
+
+            if (p.x < min.x) min.x = p.x;
+            if (p.y < min.y) min.y = p.y;
+            if (q.x > max.x) max.x = q.x;
+            if (q.y > max.y) max.y = q.y;
+         }
+
+         std::vector<std::unique_ptr<Entry> > displaced;
+         moveMany_r(Range(min, max - min), moves, newBoundingBoxes, displaced);
+
+         for (uint_t i = 0; i < displaced.size(); ++i)
+            insert_r(displaced[i]->item, displaced[i]->rect);
+      }
+
       //===========================================
       // Quadtree::removeAll
       //===========================================
@@ -229,7 +267,7 @@ class Quadtree : public SpatialContainer<T> {
       //===========================================
       // Quadtree::remove_
       //===========================================
-      bool remove_(T item) {
+      bool remove_(const T& item) {
          for (uint_t i = 0; i < m_entries.size(); ++i) {
             if (m_entries[i]->item == item) {
                if (getIndex(m_entries[i]->rect) != -1)
@@ -246,7 +284,7 @@ class Quadtree : public SpatialContainer<T> {
       //===========================================
       // Quadtree::remove_r
       //===========================================
-      bool remove_r(T item, const Range& boundingBox) {
+      bool remove_r(const T& item, const Range& boundingBox) {
          if (!m_boundary.overlaps(boundingBox))
             return false;
 
@@ -264,17 +302,73 @@ class Quadtree : public SpatialContainer<T> {
          return remove_(item);
       }
 
+      //===========================================
+      // Quadtree::moveMany_r
+      //
+      // Entries that no longer belong to this node are moved into displaced.
+      //===========================================
+      void moveMany_r(const Range& region, const std::map<T, uint_t>& moves, const std::vector<Range>& newBoxes,
+         std::vector<std::unique_ptr<Entry> >& displaced) {
+
+         if (!m_boundary.overlaps(region))
+            return;
+
+         if (hasChildren()) {
+            for (int i = 0; i < 4; ++i)
+               m_children[i]->moveMany_r(region, moves, newBoxes, displaced);
+         }
+
+         uint_t n = 0;
+         for (uint_t i = 0; i < m_entries.size(); ++i) {
+            typename std::map<T, uint_t>::const_iterator it = moves.find(m_entries[i]->item);
+
+            if (it != moves.end()) {
+               const Range& rect = newBoxes[it->second];
+               int c = getIndex(rect);
+
+               if (getIndex(m_entries[i]->rect) != -1)
+                  --m_n;
+
+               m_entries[i]->rect = rect;
+
+               // A node with children only keeps entries that don't fit in any of them
+               if (!m_boundary.contains(rect) || (hasChildren() && c != -1)) {
+                  displaced.push_back(std::move(m_entries[i]));
+                  continue;
+               }
+
+               if (c != -1) ++m_n;
+            }
+
+            if (n != i) m_entries[n] = std::move(m_entries[i]);
+            ++n;
+         }
+         m_entries.resize(n);
+
+         if (hasChildren()) {
+            int t = 0;
+            for (int i = 0; i < 4; ++i)
+               t += m_children[i]->getNumEntries();
+
+            if (t <= m_splittingThres)
+               remerge();
+         }
+         else if (m_n > m_splittingThres) {
+            subdivide();
+         }
+      }
+
       //===========================================
       // Quadtree::insert_
       //===========================================
-      void insert_(T item, const Range& boundingBox) {
+      void insert_(const T& item, const Range& boundingBox) {
          m_entries.push_back(std::unique_ptr<Entry>(new Entry(item, boundingBox)));
       }
 
       //===========================================
       // Quadtree::insert_r
       //===========================================
-      bool insert_r(T item, const Range& boundingBox) {
+      bool insert_r(const T& item, const Range& boundingBox) {
          if (!m_boundary.contains(boundingBox))
             return false;
 
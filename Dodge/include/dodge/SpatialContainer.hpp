@@ -22,8 +22,13 @@ class Range;
 template <typename T>
 class SpatialContainer {
    public:
-      virtual bool insert(T item, const Range& boundingBox) = 0;
-      virtual bool remove(T item, const Range& boundingBox) = 0;
+      virtual bool insert(const T& item, const Range& boundingBox) = 0;
+      virtual bool remove(const T& item, const Range& boundingBox) = 0;
+
+      // Equivalent to a remove() and insert() per item, but done in one pass
+      virtual void moveMany(const std::vector<T>& items, const std::vector<Range>& oldBoundingBoxes,
+         const std::vector<Range>& newBoundingBoxes) = 0;
+
       virtual void removeAll() = 0;
       virtual int getNumEntries() const = 0;
       virtual void getEntries(const Range& region, std::vector<T>& entries) const = 0;
@@ -42,6 +42,7 @@ class Sprite
       virtual void removeFromWorld();
 
       virtual void draw() const;
+      virtual void getModels(std::vector<IModel*>& models) const;
 
       virtual void update();
 
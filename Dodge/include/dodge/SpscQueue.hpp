@@ -0,0 +1,129 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __SPSC_QUEUE_HPP__
+#define __SPSC_QUEUE_HPP__
+
+
+#include <cstddef>
+#include <atomic>
+#include <type_traits>
+#include "definitions.hpp"
+#include "Exception.hpp"
+
+
+namespace Dodge {
+
+
+// Fixed-capacity, lock-free queue for one producer thread and one consumer
+// thread. Elements are copied in and out, so T should be a POD type.
+template <class T>
+class SpscQueue {
+   static_assert(std::is_pod<T>::value, "SpscQueue elements must be POD");
+
+   public:
+      explicit SpscQueue(size_t capacity);
+
+      bool push(const T& item);
+      bool pop(T& item);
+
+      inline bool empty() const;
+      inline size_t getCapacity() const;
+
+      ~SpscQueue();
+
+   private:
+      SpscQueue(const SpscQueue&);
+      SpscQueue& operator=(const SpscQueue&);
+
+      T* m_items;
+      size_t m_mask;
+
+      // Both indices increase indefinitely and are masked on use
+      std::atomic<size_t> m_head;
+      std::atomic<size_t> m_tail;
+};
+
+//===========================================
+// SpscQueue::SpscQueue
+//
+// Capacity must be a power of 2.
+//===========================================
+template <class T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+   : m_items(NULL),
+     m_mask(capacity - 1),
+     m_head(0),
+     m_tail(0) {
+
+   if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+      throw Exception("Error constructing SpscQueue; Capacity must be a power of 2", __FILE__, __LINE__);
+
+   m_items = new T[capacity];
+}
+
+//===========================================
+// SpscQueue::push
+//
+// Called by the producer only. Returns false if the queue is full.
+//===========================================
+template <class T>
+bool SpscQueue<T>::push(const T& item) {
+   size_t head = m_head.load(std::memory_order_relaxed);
+
+   if (head - m_tail.load(std::memory_order_acquire) > m_mask) return false;
+
+   m_items[head & m_mask] = item;
+   m_head.store(head + 1, std::memory_order_release);
+
+   return true;
+}
+
+//===========================================
+// SpscQueue::pop
+//
+// Called by the consumer only. Returns false if the queue is empty.
+//===========================================
+template <class T>
+bool SpscQueue<T>::pop(T& item) {
+   size_t tail = m_tail.load(std::memory_order_relaxed);
+
+   if (tail == m_head.load(std::memory_order_acquire)) return false;
+
+   item = m_items[tail & m_mask];
+   m_tail.store(tail + 1, std::memory_order_release);
+
+   return true;
+}
+
+//===========================================
+// SpscQueue::empty
+//===========================================
+template <class T>
+inline bool SpscQueue<T>::empty() const {
+   return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+}
+
+//===========================================
+// SpscQueue::getCapacity
+//===========================================
+template <class T>
+inline size_t SpscQueue<T>::getCapacity() const {
+   return m_mask + 1;
+}
+
+//===========================================
+// SpscQueue::~SpscQueue
+//===========================================
+template <class T>
+SpscQueue<T>::~SpscQueue() {
+   delete[] m_items;
+}
+
+
+}
+
+
+#endif /*!__SPSC_QUEUE_HPP__*/
@@ -10,6 +10,9 @@
 namespace Dodge {
 
 
+// The glyphs are tessellated in model space, so moving the entity only changes
+// the model's matrix. Changing the text re-tessellates only the characters that
+// differ.
 class TextEntity : virtual public Entity {
    public:
       explicit TextEntity(const XmlNode data);
@@ -28,6 +31,7 @@ class TextEntity : virtual public Entity {
       virtual void setZ(float32_t z);
 
       virtual void draw() const;
+      virtual void getModels(std::vector<IModel*>& models) const;
 
       virtual void update();
 
@@ -53,7 +57,9 @@ class TextEntity : virtual public Entity {
 
       mutable PlainTexturedAlphaModel m_model;
 
+      void tessellate(uint_t first, uint_t last) const;
       void updateModel() const;
+      void updateMatrix() const;
 };
 
 typedef boost::shared_ptr<TextEntity> pTextEntity_t;
@@ -0,0 +1,244 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __TRANSFORM_STORE_HPP__
+#define __TRANSFORM_STORE_HPP__
+
+
+#include <vector>
+#include <mutex>
+#include "definitions.hpp"
+#include "math/Vec2f.hpp"
+
+
+namespace Dodge {
+
+
+class Entity;
+
+// Structure-of-arrays mirror of entity transforms. When enabled, each entity
+// claims a slot on construction and keeps it up to date whenever it is
+// transformed, so that batch systems (culling, physics sync, etc.) can
+// stream over contiguous arrays instead of chasing entity pointers.
+//
+// The store must be enabled before any entities that should use it are
+// constructed. Slots of destroyed entities are recycled; check isAlive()
+// when iterating. As with EntityRegistry, slots can't be allocated while
+// EntityScheduler is running in parallel.
+class TransformStore {
+   public:
+      typedef int index_t;
+
+      static const index_t NULL_INDEX = -1;
+
+      inline void setEnabled(bool b);
+      inline bool isEnabled() const;
+
+      index_t allocate(Entity* entity);
+      void release(index_t idx);
+
+      inline void setTransform(index_t idx, const Vec2f& transl, const Vec2f& transl_abs, float32_t rot,
+         float32_t rot_abs, const Vec2f& scale);
+      inline void setZ(index_t idx, float32_t z);
+      inline void setParent(index_t idx, index_t parent);
+      inline void setBoundary(index_t idx, const Vec2f& pos, const Vec2f& size);
+
+      inline size_t size() const;
+      inline bool isAlive(index_t idx) const;
+
+      inline bool boundaryOverlaps(index_t idx, const Vec2f& pos, const Vec2f& size) const;
+
+      inline Entity* const* getEntities() const;
+      inline const Vec2f* getTranslations() const;
+      inline const Vec2f* getTranslations_abs() const;
+      inline const float32_t* getRotations() const;
+      inline const float32_t* getRotations_abs() const;
+      inline const Vec2f* getScales() const;
+      inline const float32_t* getZValues() const;
+      inline const index_t* getParents() const;
+      inline const Vec2f* getBoundaryPositions() const;
+      inline const Vec2f* getBoundarySizes() const;
+
+   private:
+      struct arrays_t {
+         std::vector<Entity*> entity;
+         std::vector<Vec2f> transl;
+         std::vector<Vec2f> transl_abs;
+         std::vector<float32_t> rot;
+         std::vector<float32_t> rot_abs;
+         std::vector<Vec2f> scale;
+         std::vector<float32_t> z;
+         std::vector<index_t> parent;
+         std::vector<Vec2f> boundPos;
+         std::vector<Vec2f> boundSize;
+
+         std::vector<index_t> freeList;
+      };
+
+      static bool m_enabled;
+
+      // Allocated by the first allocate() and never freed, so that entities
+      // held in static containers can still release their slots while the
+      // program exits
+      static arrays_t* m_arrays;
+      static std::mutex m_freeListMutex;
+};
+
+//===========================================
+// TransformStore::setEnabled
+//===========================================
+inline void TransformStore::setEnabled(bool b) {
+   m_enabled = b;
+}
+
+//===========================================
+// TransformStore::isEnabled
+//===========================================
+inline bool TransformStore::isEnabled() const {
+   return m_enabled;
+}
+
+//===========================================
+// TransformStore::setTransform
+//===========================================
+inline void TransformStore::setTransform(index_t idx, const Vec2f& transl, const Vec2f& transl_abs,
+   float32_t rot, float32_t rot_abs, const Vec2f& scale) {
+
+   m_arrays->transl[idx] = transl;
+   m_arrays->transl_abs[idx] = transl_abs;
+   m_arrays->rot[idx] = rot;
+   m_arrays->rot_abs[idx] = rot_abs;
+   m_arrays->scale[idx] = scale;
+}
+
+//===========================================
+// TransformStore::setZ
+//===========================================
+inline void TransformStore::setZ(index_t idx, float32_t z) {
+   m_arrays->z[idx] = z;
+}
+
+//===========================================
+// TransformStore::setParent
+//===========================================
+inline void TransformStore::setParent(index_t idx, index_t parent) {
+   m_arrays->parent[idx] = parent;
+}
+
+//===========================================
+// TransformStore::setBoundary
+//===========================================
+inline void TransformStore::setBoundary(index_t idx, const Vec2f& pos, const Vec2f& size) {
+   m_arrays->boundPos[idx] = pos;
+   m_arrays->boundSize[idx] = size;
+}
+
+//===========================================
+// TransformStore::size
+//
+// Number of slots, including dead ones.
+//===========================================
+inline size_t TransformStore::size() const {
+   return m_arrays ? m_arrays->entity.size() : 0;
+}
+
+//===========================================
+// TransformStore::isAlive
+//===========================================
+inline bool TransformStore::isAlive(index_t idx) const {
+   return m_arrays->entity[idx] != NULL;
+}
+
+//===========================================
+// TransformStore::boundaryOverlaps
+//
+// Same test as Range::overlaps(), against the region at pos with the given
+// size.
+//===========================================
+inline bool TransformStore::boundaryOverlaps(index_t idx, const Vec2f& pos, const Vec2f& size) const {
+   const Vec2f& bPos = m_arrays->boundPos[idx];
+   const Vec2f& bSize = m_arrays->boundSize[idx];
+
+   return pos.x < bPos.x + bSize.x
+      && pos.x + size.x > bPos.x
+      && pos.y < bPos.y + bSize.y
+      && pos.y + size.y > bPos.y;
+}
+
+//===========================================
+// TransformStore::getEntities
+//===========================================
+inline Entity* const* TransformStore::getEntities() const {
+   return m_arrays ? m_arrays->entity.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getTranslations
+//===========================================
+inline const Vec2f* TransformStore::getTranslations() const {
+   return m_arrays ? m_arrays->transl.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getTranslations_abs
+//===========================================
+inline const Vec2f* TransformStore::getTranslations_abs() const {
+   return m_arrays ? m_arrays->transl_abs.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getRotations
+//===========================================
+inline const float32_t* TransformStore::getRotations() const {
+   return m_arrays ? m_arrays->rot.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getRotations_abs
+//===========================================
+inline const float32_t* TransformStore::getRotations_abs() const {
+   return m_arrays ? m_arrays->rot_abs.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getScales
+//===========================================
+inline const Vec2f* TransformStore::getScales() const {
+   return m_arrays ? m_arrays->scale.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getZValues
+//===========================================
+inline const float32_t* TransformStore::getZValues() const {
+   return m_arrays ? m_arrays->z.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getParents
+//===========================================
+inline const TransformStore::index_t* TransformStore::getParents() const {
+   return m_arrays ? m_arrays->parent.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getBoundaryPositions
+//===========================================
+inline const Vec2f* TransformStore::getBoundaryPositions() const {
+   return m_arrays ? m_arrays->boundPos.data() : NULL;
+}
+
+//===========================================
+// TransformStore::getBoundarySizes
+//===========================================
+inline const Vec2f* TransformStore::getBoundarySizes() const {
+   return m_arrays ? m_arrays->boundSize.data() : NULL;
+}
+
+
+}
+
+
+#endif /*!__TRANSFORM_STORE_HPP__*/
@@ -48,6 +48,7 @@ class WorldSpace {
       static std::set<pEntity_t> m_tracking;
 
       void entityMovedHandler(EEvent* e);
+      void entityBatchMovedHandler(EEvent* e);
 };
 
 
@@ -11,6 +11,12 @@
 #define RAD_TO_DEG(x) ((x) * 57.29578f)
 #define DEG_TO_RAD(x) ((x) * 0.01745329f)
 
+#ifdef WIN32
+   #define THREAD_LOCAL __declspec(thread)
+#else
+   #define THREAD_LOCAL __thread
+#endif
+
 #define LOOP_START \
    { \
       Dodge::Timer lpStart_timer;
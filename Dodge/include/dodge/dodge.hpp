@@ -7,6 +7,7 @@
 #define __DODGE_HPP__
 
 
+#include "ActivityManager.hpp"
 #include "Animation.hpp"
 #include "AnimFrame.hpp"
 #include "Asset.hpp"
@@ -19,8 +20,11 @@
 #include "EGL_CHECK.hpp"
 #include "Entity.hpp"
 #include "EntityAnimations.hpp"
+#include "EntityHandle.hpp"
 #include "EntityParallax.hpp"
 #include "EntityPhysics.hpp"
+#include "EntityRegistry.hpp"
+#include "EntityScheduler.hpp"
 #include "EventManager.hpp"
 #include "Exception.hpp"
 #include "globals.hpp"
@@ -28,6 +32,7 @@
 #include "MapLoader.hpp"
 #include "math/math.hpp"
 #include "ParallaxSprite.hpp"
+#include "PayloadRing.hpp"
 #include "PhysicalEntity.hpp"
 #include "PhysicalSprite.hpp"
 #include "platformUtils.hpp"
@@ -37,11 +42,13 @@
 #include "Range.hpp"
 #include "renderer/renderer.hpp"
 #include "SpatialContainer.hpp"
+#include "SpscQueue.hpp"
 #include "Sprite.hpp"
 #include "StackAllocator.hpp"
 #include "StringId.hpp"
 #include "TextEntity.hpp"
 #include "Timer.hpp"
+#include "TransformStore.hpp"
 #include "ui/ui.hpp"
 #include "WinIO.hpp"
 #include "WorldSpace.hpp"
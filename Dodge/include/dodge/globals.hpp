@@ -31,6 +31,7 @@ extern void gInitialise(const projectSettings_t& settings = projectSettings_t())
 
 extern float32_t gGetTargetFrameRate();
 extern StackAllocator& gGetMemStack();
+extern void gSetThreadMemStack(StackAllocator* stack);
 extern Vec2f gGetPixelSize();
 extern const std::string& gGetWorkingDir();
 extern int gFlag; // TODO
@@ -7,6 +7,7 @@
 #define __COMMON_HPP__
 
 
+#include <vector>
 #include "../definitions.hpp"
 
 
@@ -18,6 +19,7 @@ namespace Math {
 
 
 extern bool lineIntersect(const Vec2f& l1p1, const Vec2f& l1p2, const Vec2f& l2p1, const Vec2f& l2p2, Vec2f& p);
+extern void triangulate(const std::vector<Vec2f>& poly, std::vector<int>& triangles);
 
 inline bool isBetween(float32_t a, float32_t b, float32_t c) {
    return !((a < b && a < c) || (a > b && a > c));
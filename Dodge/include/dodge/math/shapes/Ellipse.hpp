@@ -36,6 +36,7 @@ class Ellipse : public Shape {
 
       virtual void setRenderTransform(float32_t x, float32_t y, float32_t z) const {}
       virtual void draw() const {}
+      virtual void getModels(std::vector<IModel*>& models) const {}
 
       Ellipse& operator=(const Ellipse& rhs) { return *this; } // TODO
 
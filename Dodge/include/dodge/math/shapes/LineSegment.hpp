@@ -47,6 +47,7 @@ class LineSegment : public Shape {
 
       virtual void setRenderTransform(float32_t x, float32_t y, float32_t z) const;
       virtual void draw() const;
+      virtual void getModels(std::vector<IModel*>& models) const;
 
       LineSegment& operator=(const LineSegment& rhs);
 
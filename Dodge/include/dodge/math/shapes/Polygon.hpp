@@ -8,6 +8,7 @@
 
 
 #include <vector>
+#include <memory>
 #include <boost/shared_ptr.hpp>
 #include "Shape.hpp"
 #include "../Vec2f.hpp"
@@ -19,6 +20,8 @@
 namespace Dodge {
 
 
+// Render models are only built when the polygon is drawn, so polygons used
+// purely for their geometry (e.g. by the physics engine) carry no render state.
 class Polygon : public Shape {
    public:
       Polygon();
@@ -56,6 +59,7 @@ class Polygon : public Shape {
 
       virtual void setRenderTransform(float32_t x, float32_t y, float32_t z) const;
       virtual void draw() const;
+      virtual void getModels(std::vector<IModel*>& models) const;
 
       Polygon& operator=(const Polygon& rhs);
 
@@ -66,6 +70,23 @@ class Polygon : public Shape {
       virtual ~Polygon();
 
    private:
+      // Created the first time the polygon is drawn or given a colour
+      struct renderState_t {
+         renderState_t();
+
+         PlainNonTexturedAlphaModel outlineModel;
+         PlainNonTexturedAlphaModel interiorModel;
+
+         // True if the models are out of date with the vertices
+         bool dirty;
+
+         // Vertex indices of the interior's triangles. Rotating or scaling the
+         // polygon doesn't change them, so they're only recomputed when
+         // vertices are added, removed or moved individually.
+         std::vector<int> triangles;
+         bool trianglesDirty;
+      };
+
       void deepCopy(const Polygon& copy);
 
       void restructure();
@@ -73,6 +94,9 @@ class Polygon : public Shape {
       void subdivide();
       void absorbChildren();
 
+      renderState_t& getRenderState() const;
+      inline void invalidateModels();
+      inline void invalidateTriangulation();
       void updateModels() const;
       void updateInteriorModel() const;
       void updateOutlineModel() const;
@@ -81,9 +105,7 @@ class Polygon : public Shape {
       int m_nVerts;
       std::vector<Polygon> m_children;
 
-      mutable PlainNonTexturedAlphaModel m_outlineModel;
-      mutable PlainNonTexturedAlphaModel m_interiorModel;
-      Renderer& m_renderer;
+      mutable std::unique_ptr<renderState_t> m_render;
 };
 
 //===========================================
@@ -120,7 +142,7 @@ inline void Polygon::setVertex(int idx, const Vec2f& vert) {
    *m_verts[idx] = vert;
 
    restructure();
-   updateModels();
+   invalidateTriangulation();
 }
 
 //===========================================
@@ -144,6 +166,25 @@ inline void Polygon::insertVertex(int idx, float32_t x, float32_t y) {
    insertVertex(idx, Vec2f(x, y));
 }
 
+//===========================================
+// Polygon::invalidateModels
+//
+// The models are rebuilt the next time they're needed.
+//===========================================
+inline void Polygon::invalidateModels() {
+   if (m_render) m_render->dirty = true;
+}
+
+//===========================================
+// Polygon::invalidateTriangulation
+//===========================================
+inline void Polygon::invalidateTriangulation() {
+   if (m_render) {
+      m_render->dirty = true;
+      m_render->trianglesDirty = true;
+   }
+}
+
 
 }
 
@@ -5,6 +5,7 @@
 #ifdef DEBUG
 #include <ostream>
 #endif
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include "../../xml/xml.hpp"
 #include "../../StringId.hpp"
@@ -16,6 +17,8 @@
 namespace Dodge {
 
 
+class IModel;
+
 // A shape does not have any explicit position defined (though
 // some shapes such as polygons, which are represented as sequences of vertices,
 // will have an implicit position because all vertices can be moved).
@@ -41,6 +44,9 @@ class Shape : virtual public Asset {
       virtual void setRenderTransform(float32_t x, float32_t y, float32_t z) const = 0;
       virtual void draw() const = 0;
 
+      // Appends the models that draw() would draw
+      virtual void getModels(std::vector<IModel*>& models) const = 0;
+
       virtual ~Shape() {};
 };
 
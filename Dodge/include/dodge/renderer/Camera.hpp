@@ -2,7 +2,7 @@
 #define __CAMERA_HPP__
 
 
-#include <mutex>
+#include <atomic>
 #include <boost/shared_ptr.hpp>
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
 #include <cml/cml.h>
@@ -14,10 +14,15 @@
 namespace Dodge {
 
 
+// The camera is guarded by a sequence lock, so neither reads nor writes ever
+// block. Only one thread (normally the main thread) may modify the camera, but
+// any thread may read it; a reader that overlaps a write simply retries.
 class Camera {
    public:
-      Camera(float32_t w, float32_t h) {
-         m_matrix = cml::identity_4x4();
+      Camera(float32_t w, float32_t h)
+         : m_seq(0) {
+
+         m_state.matrix = cml::identity_4x4();
          setProjection(w, h);
          setTranslation(0.f, 0.f);
       }
@@ -35,10 +40,19 @@ class Camera {
       inline Vec2f getViewSize() const;
 
    private:
-      cml::matrix44f_c m_matrix;
-      Vec2f m_viewSize;
+      struct state_t {
+         cml::matrix44f_c matrix;
+         Vec2f viewSize;
+      };
+
+      inline void beginWrite();
+      inline void endWrite();
+      inline state_t getState() const;
 
-      mutable std::mutex m_mutex;
+      state_t m_state;
+
+      // Odd while a write is in progress
+      std::atomic<uint_t> m_seq;
 };
 
 typedef boost::shared_ptr<Camera> pCamera_t;
@@ -61,48 +75,76 @@ inline void Camera::translate(const Vec2f& ds) {
 // Camera::translate
 //===========================================
 inline void Camera::translate(float32_t dx, float32_t dy) {
-   m_mutex.lock();
-   m_matrix.data()[12] -= dx;
-   m_matrix.data()[13] -= dy;
-   m_mutex.unlock();
+   beginWrite();
+   m_state.matrix.data()[12] -= dx;
+   m_state.matrix.data()[13] -= dy;
+   endWrite();
 }
 
 //===========================================
 // Camera::translate_x
 //===========================================
 inline void Camera::translate_x(float32_t dx) {
-   m_mutex.lock();
-   m_matrix.data()[12] -= dx;
-   m_mutex.unlock();
+   beginWrite();
+   m_state.matrix.data()[12] -= dx;
+   endWrite();
 }
 
 //===========================================
 // Camera::translate_y
 //===========================================
 inline void Camera::translate_y(float32_t dy) {
-   m_mutex.lock();
-   m_matrix.data()[13] -= dy;
-   m_mutex.unlock();
+   beginWrite();
+   m_state.matrix.data()[13] -= dy;
+   endWrite();
 }
 
 //===========================================
 // Camera::getMatrix
 //===========================================
 inline void Camera::getMatrix(cml::matrix44f_c& matrix) const {
-   m_mutex.lock();
-   matrix = m_matrix;
-   m_mutex.unlock();
+   matrix = getState().matrix;
 }
 
 //===========================================
 // Camera::getViewSize
 //===========================================
 inline Vec2f Camera::getViewSize() const {
-   m_mutex.lock();
-   Vec2f cpy = m_viewSize;
-   m_mutex.unlock();
+   return getState().viewSize;
+}
+
+//===========================================
+// Camera::beginWrite
+//===========================================
+inline void Camera::beginWrite() {
+   m_seq.store(m_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+}
+
+//===========================================
+// Camera::endWrite
+//===========================================
+inline void Camera::endWrite() {
+   m_seq.store(m_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//===========================================
+// Camera::getState
+//
+// Returns a consistent copy of the camera's state, retrying if a write was in
+// progress while it was being copied.
+//===========================================
+inline Camera::state_t Camera::getState() const {
+   state_t state;
+   uint_t seq;
+
+   do {
+      seq = m_seq.load(std::memory_order_acquire);
+      state = m_state;
+      std::atomic_thread_fence(std::memory_order_acquire);
+   } while ((seq & 1) || seq != m_seq.load(std::memory_order_relaxed));
 
-   return cpy;
+   return state;
 }
 
 
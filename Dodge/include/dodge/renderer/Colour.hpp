@@ -3,7 +3,9 @@
  * Date: 2012
  */
 
-#ifdef WIN32
+#ifdef HEADLESS
+   #include "headless/Colour.hpp"
+#elif defined WIN32
    #include "ogl/Colour.hpp"
 #else
    #include "ogl/Colour.hpp"
@@ -0,0 +1,99 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __DRAW_LIST_HPP__
+#define __DRAW_LIST_HPP__
+
+
+#include <vector>
+#include "../definitions.hpp"
+
+
+namespace Dodge {
+
+
+class IModel;
+
+// A list of models recorded by a single thread, so that models can be drawn
+// from several threads at once without contending for the renderer's locks.
+//
+// Recording isn't thread-safe, so each thread should have a list of its own.
+// When a thread has finished recording, its list is passed to
+// Renderer::submit(). At the next tick() the submitted lists are merged into
+// the frame after any models drawn with Renderer::draw(), in ascending order
+// of their order values, and each list's models in the order they were
+// recorded. The resulting frame is the same however the threads were
+// scheduled, provided no two lists share an order value. Lists are cleared
+// once merged, ready to be recorded into again.
+//
+// Models are referenced rather than copied, so must remain alive and unchanged
+// until the next tick(). Renderer::redirectDraws() records the calling
+// thread's Renderer::draw() calls into a list, so existing draw code needn't
+// know about lists.
+class DrawList {
+   public:
+      explicit DrawList(int order)
+         : m_order(order) {}
+
+      inline void draw(const IModel* model);
+      inline void clear();
+
+      inline void setOrder(int order);
+      inline int getOrder() const;
+      inline uint_t getNumModels() const;
+      inline const IModel* getModel(uint_t i) const;
+
+   private:
+      int m_order;
+      std::vector<const IModel*> m_models;
+};
+
+//===========================================
+// DrawList::draw
+//===========================================
+inline void DrawList::draw(const IModel* model) {
+   m_models.push_back(model);
+}
+
+//===========================================
+// DrawList::clear
+//===========================================
+inline void DrawList::clear() {
+   m_models.clear();
+}
+
+//===========================================
+// DrawList::setOrder
+//===========================================
+inline void DrawList::setOrder(int order) {
+   m_order = order;
+}
+
+//===========================================
+// DrawList::getOrder
+//===========================================
+inline int DrawList::getOrder() const {
+   return m_order;
+}
+
+//===========================================
+// DrawList::getNumModels
+//===========================================
+inline uint_t DrawList::getNumModels() const {
+   return m_models.size();
+}
+
+//===========================================
+// DrawList::getModel
+//===========================================
+inline const IModel* DrawList::getModel(uint_t i) const {
+   return m_models[i];
+}
+
+
+}
+
+
+#endif /*!__DRAW_LIST_HPP__*/
@@ -7,6 +7,7 @@
 #define __FONT_HPP__
 
 
+#include <vector>
 #include "../definitions.hpp"
 #include "Texture.hpp"
 #include "../Asset.hpp"
@@ -18,8 +19,17 @@ namespace Dodge {
 
 class XmlNode;
 
+// Characters are laid out in rows across the texture section, starting with
+// ' ' at the top-left.
 class Font : virtual public Asset {
    public:
+      // Texture coordinates of a character. (u1, v1) is the bottom-left corner
+      // of the character and (u2, v2) the top-right.
+      struct glyph_t {
+         float32_t u1, v1;
+         float32_t u2, v2;
+      };
+
       Font(const XmlNode data);
       Font(pTexture_t texture, float32_t texX, float32_t texY, float32_t texW, float32_t texH, int charW, int charH);
       Font(const Font& copy);
@@ -30,13 +40,23 @@ class Font : virtual public Asset {
       inline const pTexture_t getTexture() const;
       inline int getCharWidth() const;
       inline int getCharHeight() const;
-      inline const Range& getTextureSection() const;
+      inline Range getTextureSection() const;
+
+      glyph_t getGlyph(char c) const;
 
    private:
+      void buildGlyphs();
+
       pTexture_t m_texture;
       Range m_texSection;
       int m_charW;
       int m_charH;
+
+      // Texture coordinates of each character within the font's own texture,
+      // computed on construction. getGlyph() maps them into the atlas if the
+      // texture has since been moved into one, so the table never changes
+      // and can be read from any thread.
+      std::vector<glyph_t> m_glyphs;
 };
 
 typedef boost::shared_ptr<Font> pFont_t;
@@ -50,9 +70,11 @@ inline const pTexture_t Font::getTexture() const {
 
 //===========================================
 // Font::getTextureSection
+//
+// If the font's texture is in an atlas, the section is given relative to the atlas.
 //===========================================
-inline const Range& Font::getTextureSection() const {
-   return m_texSection;
+inline Range Font::getTextureSection() const {
+   return m_texture->mapSection(m_texSection);
 }
 
 //===========================================
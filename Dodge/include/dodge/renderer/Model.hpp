@@ -7,6 +7,7 @@
 #define __MODEL_HPP__
 
 
+#include <atomic>
 #include "../StringId.hpp"
 #include "Renderer.hpp"
 
@@ -16,24 +17,34 @@ namespace Dodge {
 
 class IModel {
    friend class SceneGraph;
+   friend class ModelCache;
    friend class RenderMode;
    friend class Renderer;
+   friend class RenderRules;
 
    public:
       //===========================================
       // IModel::IModel
+      //
+      // Doesn't assign an id. Used for snapshots, which take the id of the
+      // model they copy, and for the renderer's own temporary models.
       //===========================================
       IModel()
          : m_primitiveType(Renderer::TRIANGLES),
            m_renderMode(Renderer::UNDEFINED),
-           m_id(nextId) {
-
-         ++nextId;
+           m_id(-1),
+           m_version(0),
+           m_dynamic(false),
+           m_baked(false),
+           m_geometryId(0),
+           m_bufferSlot(-1) {
 
          m_matrix[0] = 1.0; m_matrix[4] = 0.0; m_matrix[8]  = 0.0; m_matrix[12] = 0.0;
          m_matrix[1] = 0.0; m_matrix[5] = 1.0; m_matrix[9]  = 0.0; m_matrix[13] = 0.0;
          m_matrix[2] = 0.0; m_matrix[6] = 0.0; m_matrix[10] = 1.0; m_matrix[14] = 0.0;
          m_matrix[3] = 0.0; m_matrix[7] = 0.0; m_matrix[11] = 0.0; m_matrix[15] = 1.0;
+
+         m_texRect[0] = 0.0; m_texRect[1] = 0.0; m_texRect[2] = 1.0; m_texRect[3] = 1.0;
       }
 
       //===========================================
@@ -42,13 +53,19 @@ class IModel {
       IModel(Renderer::mode_t renderMode, Renderer::primitive_t primitiveType)
          : m_primitiveType(primitiveType),
            m_renderMode(renderMode),
-           m_id(nextId) {
+           m_id(nextId++),
+           m_version(0),
+           m_dynamic(false),
+           m_baked(false),
+           m_geometryId(0),
+           m_bufferSlot(-1) {
 
-         ++nextId;
          m_matrix[0] = 1.0; m_matrix[4] = 0.0; m_matrix[8]  = 0.0; m_matrix[12] = 0.0;
          m_matrix[1] = 0.0; m_matrix[5] = 1.0; m_matrix[9]  = 0.0; m_matrix[13] = 0.0;
          m_matrix[2] = 0.0; m_matrix[6] = 0.0; m_matrix[10] = 1.0; m_matrix[14] = 0.0;
          m_matrix[3] = 0.0; m_matrix[7] = 0.0; m_matrix[11] = 0.0; m_matrix[15] = 1.0;
+
+         m_texRect[0] = 0.0; m_texRect[1] = 0.0; m_texRect[2] = 1.0; m_texRect[3] = 1.0;
       }
 
       //===========================================
@@ -63,6 +80,7 @@ class IModel {
       //===========================================
       void setMatrix(const Renderer::matrixElement_t* matrix) {
          memcpy(m_matrix, matrix, 16 * sizeof(Renderer::matrixElement_t));
+         ++m_version;
       }
 
       //===========================================
@@ -70,6 +88,7 @@ class IModel {
       //===========================================
       void setMatrixElement(uint_t idx, Renderer::matrixElement_t val) {
          m_matrix[idx] = val;
+         ++m_version;
       }
 
       //===========================================
@@ -93,6 +112,91 @@ class IModel {
          return m_renderMode;
       }
 
+      //===========================================
+      // IModel::setDynamic
+      //
+      // Dynamic models are expected to change often, so are never given a
+      // VBO of their own. Their vertices are streamed to the GPU each frame.
+      //===========================================
+      void setDynamic(bool b) {
+         m_dynamic = b;
+         ++m_version;
+      }
+
+      //===========================================
+      // IModel::isDynamic
+      //===========================================
+      bool isDynamic() const {
+         return m_dynamic;
+      }
+
+      //===========================================
+      // IModel::setBaked
+      //
+      // A baked model's geometry has been merged into a StaticGeometry, which
+      // draws it instead, so Renderer::draw() ignores the model.
+      //===========================================
+      void setBaked(bool b) {
+         m_baked = b;
+      }
+
+      //===========================================
+      // IModel::isBaked
+      //===========================================
+      bool isBaked() const {
+         return m_baked;
+      }
+
+      //===========================================
+      // IModel::setTextureRect
+      //
+      // Texture coordinates are mapped into the rectangle at (x, y) with size
+      // (w, h) before sampling. This allows the visible section of a texture to
+      // be changed without touching the vertex data. The default is (0, 0, 1, 1).
+      //===========================================
+      void setTextureRect(Renderer::texCoordElement_t x, Renderer::texCoordElement_t y,
+         Renderer::texCoordElement_t w, Renderer::texCoordElement_t h) {
+
+         m_texRect[0] = x; m_texRect[1] = y; m_texRect[2] = w; m_texRect[3] = h;
+         ++m_version;
+      }
+
+      //===========================================
+      // IModel::getTextureRect
+      //===========================================
+      const Renderer::texCoordElement_t* getTextureRect() const {
+         return m_texRect;
+      }
+
+      //===========================================
+      // IModel::setGeometryId
+      //
+      // Models with the same non-zero geometry id must have identical vertex
+      // data, which allows the renderer to draw them as instances of one
+      // another. Only their matrix, colour and texture rect may differ.
+      //===========================================
+      void setGeometryId(long id) {
+         m_geometryId = id;
+         ++m_version;
+      }
+
+      //===========================================
+      // IModel::getGeometryId
+      //===========================================
+      long getGeometryId() const {
+         return m_geometryId;
+      }
+
+      //===========================================
+      // IModel::getVersion
+      //
+      // Changes whenever the model is modified, so a model with the same id and
+      // version as a copy made earlier is known to be identical to it.
+      //===========================================
+      unsigned long getVersion() const {
+         return m_version;
+      }
+
       virtual uint_t getNumVertices() const = 0;
       virtual void setColour(const Colour& colour) = 0;
       virtual Colour getColour() const = 0;
@@ -142,11 +246,18 @@ class IModel {
          memcpy(m_matrix, cpy.m_matrix, 16 * sizeof(Renderer::matrixElement_t));
          m_primitiveType = cpy.m_primitiveType;
          m_renderMode = cpy.m_renderMode;
+         m_dynamic = cpy.m_dynamic;
+         m_geometryId = cpy.m_geometryId;
+         memcpy(m_texRect, cpy.m_texRect, 4 * sizeof(Renderer::texCoordElement_t));
       }
 
       // Returns transformed z-coord of first vertex
       virtual float32_t getDepth() const = 0;
 
+      // Writes the model-space bounding rectangle of the vertices to bounds as
+      // (x1, y1, x2, y2). Returns false if the model has no vertices.
+      virtual bool getLocalBounds(Renderer::vertexElement_t* bounds) const = 0;
+
       virtual size_t getSizeOf() const = 0;
       virtual size_t vertexDataSize() const = 0;
       virtual const void* getVertexData() const = 0;
@@ -156,9 +267,18 @@ class IModel {
       Renderer::primitive_t m_primitiveType;
       Renderer::mode_t m_renderMode;
       long m_id;
+      unsigned long m_version;
+      bool m_dynamic;
+      bool m_baked;
+      long m_geometryId;
+      Renderer::texCoordElement_t m_texRect[4];
+
+      // The model's entry in the renderer's table of VBOs, or -1 if it hasn't
+      // been buffered
+      long m_bufferSlot;
 
    private:
-      static long nextId;
+      static std::atomic<long> nextId;
 };
 
 
@@ -174,12 +294,14 @@ class Model : public IModel {
       //===========================================
       Model(long vertLayout, Renderer::mode_t renderMode, Renderer::primitive_t primitiveType)
          : IModel(renderMode, primitiveType),
-           m_vertLayout(vertLayout), m_verts(NULL), m_n(0), m_texHandle(0), m_lineWidth(0) {}
+           m_vertLayout(vertLayout), m_verts(NULL), m_n(0), m_texHandle(0), m_lineWidth(0), m_boundsDirty(true) {}
 
       //===========================================
       // Model::Model
       //===========================================
-      Model(const Model& cpy) : m_n(0) {
+      Model(const Model& cpy)
+         : IModel(cpy.m_renderMode, cpy.m_primitiveType),
+           m_verts(NULL), m_n(0), m_boundsDirty(true) {
          deepCopy(cpy);
       }
 
@@ -203,6 +325,7 @@ class Model : public IModel {
       //===========================================
       virtual void setColour(const Colour& colour) {
          m_colour = colour;
+         ++m_version;
       }
 
       //===========================================
@@ -217,6 +340,7 @@ class Model : public IModel {
       //===========================================
       virtual void setLineWidth(Renderer::int_t lineWidth) {
          m_lineWidth = lineWidth;
+         ++m_version;
       }
 
       //===========================================
@@ -231,6 +355,7 @@ class Model : public IModel {
       //===========================================
       virtual void setTextureHandle(Renderer::textureHandle_t texHandle) {
          m_texHandle = texHandle;
+         ++m_version;
       }
 
       //===========================================
@@ -255,6 +380,8 @@ class Model : public IModel {
          }
 
          memcpy(m_verts + idx, verts, sizeof(T) * num);
+         m_boundsDirty = true;
+         ++m_version;
       }
 
       //===========================================
@@ -262,6 +389,8 @@ class Model : public IModel {
       //===========================================
       void setVertex(uint_t idx, const T& vert) {
          m_verts[idx] = vert;
+         m_boundsDirty = true;
+         ++m_version;
       }
 
       //===========================================
@@ -285,6 +414,21 @@ class Model : public IModel {
          delete[] m_verts;
          m_verts = NULL;
          m_n = 0;
+         m_boundsDirty = true;
+         ++m_version;
+      }
+
+      //===========================================
+      // Model::truncateVertices
+      //
+      // Drops all but the first num vertices, keeping the existing storage.
+      //===========================================
+      void truncateVertices(uint_t num) {
+         if (num >= m_n) return;
+
+         m_n = num;
+         m_boundsDirty = true;
+         ++m_version;
       }
 
       //===========================================
@@ -348,7 +492,8 @@ class Model : public IModel {
            m_verts(NULL),
            m_n(0),
            m_texHandle(0),
-           m_lineWidth(0) {}
+           m_lineWidth(0),
+           m_boundsDirty(true) {}
 
       //===========================================
       // Model::deepCopy
@@ -399,6 +544,32 @@ class Model : public IModel {
          return z + m_matrix[14];
       }
 
+      //===========================================
+      // Model::getLocalBounds
+      //
+      // The bounds are cached until the vertices are next modified.
+      //===========================================
+      virtual bool getLocalBounds(Renderer::vertexElement_t* bounds) const {
+         if (m_n == 0) return false;
+
+         if (m_boundsDirty) {
+            m_bounds[0] = m_bounds[2] = m_verts[0].v1;
+            m_bounds[1] = m_bounds[3] = m_verts[0].v2;
+
+            for (uint_t i = 1; i < m_n; ++i) {
+               if (m_verts[i].v1 < m_bounds[0]) m_bounds[0] = m_verts[i].v1;
+               if (m_verts[i].v2 < m_bounds[1]) m_bounds[1] = m_verts[i].v2;
+               if (m_verts[i].v1 > m_bounds[2]) m_bounds[2] = m_verts[i].v1;
+               if (m_verts[i].v2 > m_bounds[3]) m_bounds[3] = m_verts[i].v2;
+            }
+
+            m_boundsDirty = false;
+         }
+
+         memcpy(bounds, m_bounds, 4 * sizeof(Renderer::vertexElement_t));
+         return true;
+      }
+
       //===========================================
       // Model::copyTo
       //===========================================
@@ -406,6 +577,8 @@ class Model : public IModel {
          Model<T>* pModel = new(ptr) Model<T>();
          pModel->shallowCopy(*this);
          pModel->m_id = m_id;
+         pModel->m_version = m_version;
+         pModel->m_bufferSlot = m_bufferSlot;
          pModel->m_n = m_n;
 
          byte_t* p = reinterpret_cast<byte_t*>(ptr);
@@ -414,6 +587,9 @@ class Model : public IModel {
          memcpy(verts, m_verts, m_n * sizeof(T));
 
          pModel->m_verts = reinterpret_cast<T*>(verts);
+
+         pModel->m_boundsDirty = m_boundsDirty;
+         memcpy(pModel->m_bounds, m_bounds, 4 * sizeof(Renderer::vertexElement_t));
       }
 
       long m_vertLayout;
@@ -422,6 +598,9 @@ class Model : public IModel {
       Renderer::textureHandle_t m_texHandle;
       Colour m_colour;
       Renderer::int_t m_lineWidth;
+
+      mutable Renderer::vertexElement_t m_bounds[4];
+      mutable bool m_boundsDirty;
 };
 
 
@@ -507,6 +686,14 @@ struct vvvtt_t {
 };
 
 
+// Per-instance data for instanced drawing
+struct modelInstance_t {
+   Renderer::matrixElement_t mv[16];
+   Renderer::colourElement_t colour[4];
+   Renderer::texCoordElement_t texRect[4];
+};
+
+
 // DO NOT STORE DATA IN THESE CLASSES.
 class ColouredNonTexturedAlphaModel : public Model<vvvcccc_t> {
    public:
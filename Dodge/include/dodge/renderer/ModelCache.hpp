@@ -0,0 +1,66 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __MODEL_CACHE_HPP__
+#define __MODEL_CACHE_HPP__
+
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include "../definitions.hpp"
+
+
+namespace Dodge {
+
+
+class IModel;
+
+// A read-only copy of a model, as it was when the copy was made
+typedef boost::shared_ptr<const IModel> pModelSnapshot_t;
+
+
+// Keeps a copy of each model drawn, so that models that haven't changed since
+// they were last drawn needn't be copied again.
+//
+// Copies are identified by the model's id and version, and are shared between
+// frames (and so between render states) until the model changes. Copies of
+// models that weren't drawn during a frame are discarded at the end of it.
+//
+// Not thread-safe; the renderer calls it with its draw mutex locked.
+class ModelCache {
+   public:
+      ModelCache();
+
+      pModelSnapshot_t getSnapshot(const IModel* model, bool& copied);
+      void endFrame();
+
+      inline uint_t getNumModels() const;
+
+   private:
+      struct entry_t {
+         unsigned long version;
+         long frame;
+         pModelSnapshot_t snapshot;
+      };
+
+      static pModelSnapshot_t makeSnapshot(const IModel* model);
+
+      // Keyed by model id
+      std::map<long, entry_t> m_entries;
+      long m_frame;
+};
+
+//===========================================
+// ModelCache::getNumModels
+//===========================================
+inline uint_t ModelCache::getNumModels() const {
+   return m_entries.size();
+}
+
+
+}
+
+
+#endif /*!__MODEL_CACHE_HPP__*/
@@ -0,0 +1,109 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __RENDER_PROFILER_HPP__
+#define __RENDER_PROFILER_HPP__
+
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <mutex>
+#include <atomic>
+#include "../definitions.hpp"
+
+
+namespace Dodge {
+
+
+// Keeps per-frame statistics for the most recently rendered frames.
+//
+// Statistics are only gathered while the profiler is enabled. Times are in
+// milliseconds. Frames are kept in a rolling buffer, so once it's full the
+// oldest frames are discarded.
+class RenderProfiler {
+   public:
+      enum field_t {
+         // Main thread (must come before the render thread fields)
+         INSERT_TIME,         // Time spent in draw() adding models to the scene graph
+         SCRATCH_BYTES,       // Bytes of model data copied into the scene graph
+         SORT_TIME,           // Time spent sorting the scene graph in tick()
+         TICK_WAIT_TIME,      // Time tick() spent waiting on other threads
+
+         // Render thread
+         MSG_TIME,            // Time spent processing messages
+         SUBMIT_TIME,         // Time spent issuing draw calls
+         SWAP_TIME,           // Time spent swapping buffers
+         FRAME_TIME,          // Total time taken to render the frame
+         DRAW_CALLS,
+         PROGRAM_SWITCHES,
+         TEXTURE_SWITCHES,
+         VERTICES,            // Vertices in models drawn
+
+         NUM_FIELDS
+      };
+
+      struct frameStats_t {
+         frameStats_t();
+
+         long long frame;
+
+         // True if the frame repeated the previous frame's state, in which case
+         // the main thread fields are zero
+         bool duplicate;
+
+         double values[NUM_FIELDS];
+      };
+
+      static const uint_t DEFAULT_CAPACITY = 256;
+
+      explicit RenderProfiler(uint_t capacity = DEFAULT_CAPACITY);
+
+      inline void setEnabled(bool b);
+      inline bool isEnabled() const;
+
+      void record(const frameStats_t& stats);
+      void clear();
+
+      uint_t getNumFrames() const;
+      frameStats_t getFrame(uint_t i) const;
+      double getPercentile(field_t field, float32_t p) const;
+
+      void exportCsv(std::ostream& out) const;
+      void exportCsv(const std::string& file) const;
+
+      static const char* getFieldName(field_t field);
+
+   private:
+      RenderProfiler(const RenderProfiler&);
+      RenderProfiler& operator=(const RenderProfiler&);
+
+      std::vector<frameStats_t> m_frames;
+      uint_t m_next;
+      uint_t m_count;
+
+      std::atomic<bool> m_enabled;
+      mutable std::mutex m_mutex;
+};
+
+//===========================================
+// RenderProfiler::setEnabled
+//===========================================
+inline void RenderProfiler::setEnabled(bool b) {
+   m_enabled = b;
+}
+
+//===========================================
+// RenderProfiler::isEnabled
+//===========================================
+inline bool RenderProfiler::isEnabled() const {
+   return m_enabled;
+}
+
+
+}
+
+
+#endif /*!__RENDER_PROFILER_HPP__*/
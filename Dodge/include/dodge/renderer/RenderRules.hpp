@@ -0,0 +1,32 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __RENDER_RULES_HPP__
+#define __RENDER_RULES_HPP__
+
+
+#include "../definitions.hpp"
+
+
+namespace Dodge {
+
+
+class IModel;
+class Camera;
+
+// Culling and batching rules shared by the renderer implementations, so that
+// they agree on which models are drawn and in how many draw calls.
+class RenderRules {
+   public:
+      static void getCullRect(const Camera& camera, float32_t margin, float32_t* rect);
+      static bool isVisible(const IModel* model, const float32_t* cullRect);
+      static bool canBatch(const IModel* a, const IModel* b);
+};
+
+
+}
+
+
+#endif /*!__RENDER_RULES_HPP__*/
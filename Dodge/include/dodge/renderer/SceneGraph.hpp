@@ -3,25 +3,36 @@
  * Date: 2012
  */
 
-#include <set>
 #include <vector>
+#include <cstdint>
 #include "Renderer.hpp"
 #include "Model.hpp"
+#include "ModelCache.hpp"
 #include "../StackAllocator.hpp"
 
 
 namespace Dodge {
 
 
-// Stores model pointers in order; first by depth, then by render mode, and then by texture handle.
+// Stores model pointers in order; first by depth, then by render mode, then by texture handle,
+// and then in the order they were inserted.
+//
+// Models are appended unsorted and put in order by a call to sort(), which must be made before
+// iterating. Models are either copied in, or added as snapshots which the scene graph holds a
+// reference to until it's cleared.
 class SceneGraph {
    friend class iterator;
 
    private:
-      typedef std::pair<float32_t, Renderer::mode_t> subKey_t;
-      typedef std::pair<subKey_t, Renderer::textureHandle_t> key_t;
-      typedef std::pair<key_t, IModel*> entry_t;
-      typedef std::set<entry_t> container_t;
+      // Depth in the high 32 bits, then 8 bits of render mode and 24 bits of texture handle
+      typedef uint64_t key_t;
+
+      struct entry_t {
+         key_t key;
+         const IModel* model;
+      };
+
+      typedef std::vector<entry_t> container_t;
 
    public:
       static const size_t INIT_STACK_SIZE = 1024; // 1KB
@@ -47,28 +58,34 @@ class SceneGraph {
       SceneGraph();
 
       void insert(const IModel* model);
+      void insert(const pModelSnapshot_t& snapshot);
+      void sort();
 
       void clear();
       iterator begin();
       iterator end();
 
    private:
+      static key_t computeKey(const IModel* model);
+
       container_t m_container;
+      container_t m_sortBuffer;
       StackAllocator m_scratchSpace;
+      std::vector<pModelSnapshot_t> m_snapshots;
 };
 
 //===========================================
 // SceneGraph::iterator::operator*
 //===========================================
 inline const IModel* SceneGraph::iterator::operator*() {
-   return reinterpret_cast<const IModel*>(m_i->second);
+   return m_i->model;
 }
 
 //===========================================
 // SceneGraph::iterator::operator->
 //===========================================
 inline const IModel* SceneGraph::iterator::operator->() {
-   return reinterpret_cast<const IModel*>(m_i->second);
+   return m_i->model;
 }
 
 //===========================================
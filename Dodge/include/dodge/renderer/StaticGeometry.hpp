@@ -0,0 +1,99 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __STATIC_GEOMETRY_HPP__
+#define __STATIC_GEOMETRY_HPP__
+
+
+#include <vector>
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include "../definitions.hpp"
+#include "Renderer.hpp"
+#include "Model.hpp"
+
+
+namespace Dodge {
+
+
+// Merges the models of geometry that never moves into as few models as
+// possible, so that it can be drawn with a handful of draw calls.
+//
+// Models are grouped by render mode, primitive type, texture, line width and
+// depth, and each group becomes a single buffered model. A model's matrix,
+// colour and texture rect are applied to its vertices as it's added, so the
+// merged models have per-vertex colours and an identity matrix. Only models
+// drawn as TRIANGLES or LINES can be merged.
+//
+// The source models aren't modified; it's up to the caller to mark them as
+// baked so that they aren't also drawn individually.
+class StaticGeometry {
+   public:
+      // The most vertices in a single merged model. A multiple of both 2 and
+      // 3, so that primitives are never split between models.
+      static const uint_t MAX_VERTICES = 60000;
+
+      StaticGeometry();
+
+      bool add(const IModel* model);
+      void bake();
+      void draw() const;
+      void release();
+
+      inline bool isBaked() const;
+      inline uint_t getNumModels() const;
+      size_t getSize() const;
+
+      ~StaticGeometry();
+
+   private:
+      StaticGeometry(const StaticGeometry&);
+      StaticGeometry& operator=(const StaticGeometry&);
+
+      struct key_t {
+         Renderer::mode_t mode;
+         Renderer::primitive_t primitiveType;
+         Renderer::textureHandle_t texture;
+         Renderer::int_t lineWidth;
+         float32_t depth;
+
+         bool operator<(const key_t& rhs) const;
+      };
+
+      struct group_t {
+         std::vector<vvvcccc_t> nonTextured;
+         std::vector<vvvttcccc_t> textured;
+      };
+
+      void bakeModel(const key_t& key, const group_t& grp, uint_t start, uint_t num);
+
+      std::map<key_t, group_t> m_groups;
+      std::vector<boost::shared_ptr<IModel> > m_models;
+      bool m_baked;
+
+      Renderer& m_renderer;
+};
+
+//===========================================
+// StaticGeometry::isBaked
+//===========================================
+inline bool StaticGeometry::isBaked() const {
+   return m_baked;
+}
+
+//===========================================
+// StaticGeometry::getNumModels
+//
+// Returns the number of merged models.
+//===========================================
+inline uint_t StaticGeometry::getNumModels() const {
+   return m_models.size();
+}
+
+
+}
+
+
+#endif /*!__STATIC_GEOMETRY_HPP__*/
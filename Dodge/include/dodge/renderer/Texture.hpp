@@ -3,7 +3,9 @@
  * Date: 2012
  */
 
-#ifdef WIN32
+#ifdef HEADLESS
+   #include "headless/Texture.hpp"
+#elif defined WIN32
    #include "ogl/Texture.hpp"
 #else
    #include "ogl/Texture.hpp"
@@ -0,0 +1,110 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __TEXTURE_ATLAS_HPP__
+#define __TEXTURE_ATLAS_HPP__
+
+
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include "../definitions.hpp"
+#include "Renderer.hpp"
+#include "Texture.hpp"
+#include "Font.hpp"
+
+
+namespace Dodge {
+
+
+// Packs textures into a single larger texture so that models using different
+// textures can be drawn together.
+//
+// Textures are placed as they're added using the skyline bottom-left method.
+// Once all textures have been added, build() creates the atlas and points each
+// texture at it. Fonts are added by way of their textures. Textures should be
+// added before any models using them are built, as existing models keep
+// drawing from the original texture until they're next updated.
+class TextureAtlas {
+   public:
+      TextureAtlas(Renderer::int_t width, Renderer::int_t height, Renderer::int_t padding = 1);
+
+      bool addTexture(pTexture_t texture);
+      bool addFont(pFont_t font);
+      void build();
+
+      inline Renderer::int_t getWidth() const;
+      inline Renderer::int_t getHeight() const;
+      inline Renderer::textureHandle_t getHandle() const;
+      inline uint_t getNumTextures() const;
+
+      ~TextureAtlas();
+
+   private:
+      struct skylineNode_t {
+         Renderer::int_t x;
+         Renderer::int_t y;
+         Renderer::int_t w;
+      };
+
+      struct entry_t {
+         boost::weak_ptr<Texture> texture;
+         Renderer::int_t x;
+         Renderer::int_t y;
+      };
+
+      TextureAtlas(const TextureAtlas&);
+      TextureAtlas& operator=(const TextureAtlas&);
+
+      bool fits(uint_t idx, Renderer::int_t w, Renderer::int_t h, Renderer::int_t& y) const;
+      bool findPosition(Renderer::int_t w, Renderer::int_t h, uint_t& idx, Renderer::int_t& x, Renderer::int_t& y) const;
+      void addSkylineLevel(uint_t idx, Renderer::int_t x, Renderer::int_t y, Renderer::int_t w, Renderer::int_t h);
+
+      Renderer::int_t m_width;
+      Renderer::int_t m_height;
+      Renderer::int_t m_padding;
+
+      std::vector<skylineNode_t> m_skyline;
+      std::vector<entry_t> m_entries;
+
+      Renderer::textureHandle_t m_handle;
+
+      Renderer& m_renderer;
+};
+
+//===========================================
+// TextureAtlas::getWidth
+//===========================================
+inline Renderer::int_t TextureAtlas::getWidth() const {
+   return m_width;
+}
+
+//===========================================
+// TextureAtlas::getHeight
+//===========================================
+inline Renderer::int_t TextureAtlas::getHeight() const {
+   return m_height;
+}
+
+//===========================================
+// TextureAtlas::getHandle
+//
+// Returns 0 until build() has been called.
+//===========================================
+inline Renderer::textureHandle_t TextureAtlas::getHandle() const {
+   return m_handle;
+}
+
+//===========================================
+// TextureAtlas::getNumTextures
+//===========================================
+inline uint_t TextureAtlas::getNumTextures() const {
+   return m_entries.size();
+}
+
+
+}
+
+
+#endif /*!__TEXTURE_ATLAS_HPP__*/
@@ -0,0 +1,45 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __COLOUR_HPP__
+#define __COLOUR_HPP__
+
+
+#include "../../xml/xml.hpp"
+#include "../../definitions.hpp"
+
+
+namespace Dodge {
+
+
+class Colour {
+   public:
+      float32_t r, g, b, a;
+
+      Colour()
+         : r(0), g(0), b(0), a(0) {}
+
+      explicit Colour(const XmlNode data);
+
+      Colour(float32_t r_, float32_t g_, float32_t b_, float32_t a_)
+         : r(r_), g(g_), b(b_), a(a_) {}
+
+      Colour(const float32_t col[4])
+         : r(col[0]), g(col[1]), b(col[2]), a(col[3]) {}
+
+      bool operator==(const Colour& rhs) const {
+         return r == rhs.r && g == rhs.g && b == rhs.b && a == rhs.a;
+      }
+
+      bool operator!=(const Colour& rhs) const {
+         return !(*this == rhs);
+      }
+};
+
+
+}
+
+
+#endif
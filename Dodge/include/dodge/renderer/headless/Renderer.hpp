@@ -0,0 +1,374 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __RENDERER_HPP__
+#define __RENDERER_HPP__
+
+
+#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
+#include <cml/cml.h>
+#pragma GCC diagnostic pop
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include "Colour.hpp"
+#include "../Camera.hpp"
+#include "../DrawList.hpp"
+#include "../RendererException.hpp"
+#include "../RenderProfiler.hpp"
+#include "../ModelCache.hpp"
+#include "../../definitions.hpp"
+#include "../../../utils/Functor.hpp"
+
+
+namespace Dodge {
+
+
+class IModel;
+class SceneGraph;
+
+
+// Headless implementation
+//
+// Has the same interface as the OpenGL renderer, but needs no GL context or
+// window. Nothing is drawn; instead tick() walks the frame's scene graph on
+// the calling thread, splitting it into draw calls exactly as the OpenGL
+// renderer would, and records them. A checksum of each frame's contents is
+// also computed, so that the output of automated runs can be compared.
+class Renderer {
+   public:
+      static Renderer& getInstance() {
+         if (!m_instance) m_instance = new Renderer;
+         return *m_instance;
+      }
+
+      typedef int32_t int_t;
+      typedef float32_t float_t;
+      typedef float32_t vertexElement_t;
+      typedef float32_t matrixElement_t;
+      typedef float32_t colourElement_t;
+      typedef float32_t texCoordElement_t;
+      typedef byte_t textureData_t;
+      typedef uint32_t textureHandle_t;
+
+      // Always ready, as there's nothing to upload to
+      typedef std::shared_future<textureHandle_t> textureFuture_t;
+
+      enum mode_t {
+         UNDEFINED,
+         TEXTURED_ALPHA,
+         NONTEXTURED_ALPHA,
+         FIXED_FUNCTION
+         // ...
+      };
+
+      enum primitive_t {
+         TRIANGLES,
+         LINES,
+         QUADS,
+         TRIANGLE_STRIP
+      };
+
+      // A draw call that would have been issued
+      struct command_t {
+         mode_t mode;
+         primitive_t primitiveType;
+         textureHandle_t texture;
+         uint_t numModels;
+         uint_t numVertices;
+      };
+
+      //-----Main Thread-----
+      inline void attachCamera(pCamera_t camera);
+      inline Camera& getCamera() const;
+
+      void onWindowResize(int_t w, int_t h);
+
+      void bufferModel(IModel* model);
+      void freeBufferedModel(IModel* model);
+
+      textureFuture_t loadTextureAsync(const textureData_t* texture, int_t width, int_t height);
+      void loadTexture(const textureData_t* texture, int_t width, int_t height, textureHandle_t* handle);
+      void unloadTexture(textureHandle_t handle);
+
+      void draw(const IModel* model);
+      void submit(DrawList& list);
+
+      // While set, models drawn from the calling thread are recorded into
+      // list instead of the frame. Pass NULL to restore.
+      inline void redirectDraws(DrawList* list);
+#ifdef DEBUG
+      inline long getFrameRate() const;
+#endif
+      inline long getDrawCalls() const;
+      inline long getDrawCallsSaved() const;
+      inline long getModelsSubmitted() const;
+      inline long getModelsCulled() const;
+      inline long getGLCallsIssued() const;
+      inline long getGLCallsElided() const;
+      inline long long getFramesPresented() const;
+      inline long long getFramesDuplicated() const;
+      inline void setCullGuardBand(float32_t margin);
+      inline void setRenderOnChange(bool b);
+      inline void setMaxFrameRate(int_t fps);
+      inline RenderProfiler& getProfiler();
+
+      inline const std::vector<command_t>& getCommandStream() const;
+      inline uint64_t getFrameChecksum() const;
+      inline long getTexturesLoaded() const;
+
+      void loadSettingsFromFile(const std::string& file);
+      void start(Functor<void, TYPELIST_0()> makeGLContextFunc, Functor<void, TYPELIST_0()> swapFunc);
+      void stop();
+      void tick(const Colour& bgColour = Colour(0.f, 0.f, 0.f, 1.f));
+      //---------------------
+
+   private:
+      Renderer();
+
+      struct usrReqSettings_t {
+         usrReqSettings_t()
+            : batching(true),
+              cullGuardBand(0.1f) {}
+
+         bool batching;
+         float32_t cullGuardBand;
+      };
+
+      static Renderer* m_instance;
+      static THREAD_LOCAL DrawList* m_drawRedirect;
+
+      void addToFrame(const IModel* model);
+      void mergeDrawLists();
+      bool isVisible(const IModel* model);
+      size_t insertModel(const IModel* model);
+      bool canBatch(const IModel* a, const IModel* b) const;
+      void render(const Colour& bgColour, long& vertices);
+      uint_t recordBatch();
+      void hash(const void* data, size_t size);
+#ifdef DEBUG
+      void computeFrameRate();
+#endif
+
+      usrReqSettings_t m_usrReqSettings;
+
+      std::unique_ptr<SceneGraph> m_sceneGraph;
+      std::mutex m_drawMutex;
+
+      // Lists submitted since the last tick
+      std::vector<DrawList*> m_drawLists;
+
+      // Copies of the models drawn, reused between frames
+      ModelCache m_modelCache;
+
+      // Main thread statistics for the frame being built
+      RenderProfiler::frameStats_t m_frameStats;
+
+      // Region outside of which models are culled, as (x1, y1, x2, y2). Taken
+      // from the camera on the first call to draw() each frame.
+      float32_t m_cullRect[4];
+      bool m_cullRectValid;
+
+      long m_frameModelsSubmitted;
+      long m_frameModelsCulled;
+      long m_modelsSubmitted;
+      long m_modelsCulled;
+
+      // Consecutive models that would be drawn together
+      std::vector<const IModel*> m_batch;
+
+      std::vector<command_t> m_commands;
+      uint64_t m_checksum;
+
+      long m_drawCalls;
+      long m_drawCallsSaved;
+      long long m_framesPresented;
+
+      std::atomic<textureHandle_t> m_nextTextureHandle;
+      std::atomic<long> m_texturesLoaded;
+
+      pCamera_t m_camera;
+
+      bool m_running;
+
+#ifdef DEBUG
+      long m_frameRate;
+#endif
+
+      RenderProfiler m_profiler;
+};
+
+#ifdef DEBUG
+//===========================================
+// Renderer::getFrameRate
+//===========================================
+inline long Renderer::getFrameRate() const {
+   return m_frameRate;
+}
+#endif
+
+//===========================================
+// Renderer::getDrawCalls
+//
+// Number of draw calls the most recent frame would have needed.
+//===========================================
+inline long Renderer::getDrawCalls() const {
+   return m_drawCalls;
+}
+
+//===========================================
+// Renderer::getDrawCallsSaved
+//
+// Number of draw calls batching would have saved in the most recent frame.
+//===========================================
+inline long Renderer::getDrawCallsSaved() const {
+   return m_drawCallsSaved;
+}
+
+//===========================================
+// Renderer::getModelsSubmitted
+//
+// Number of models that passed culling in the most recently completed frame.
+//===========================================
+inline long Renderer::getModelsSubmitted() const {
+   return m_modelsSubmitted;
+}
+
+//===========================================
+// Renderer::getModelsCulled
+//
+// Number of models rejected by culling in the most recently completed frame.
+//===========================================
+inline long Renderer::getModelsCulled() const {
+   return m_modelsCulled;
+}
+
+//===========================================
+// Renderer::getGLCallsIssued
+//
+// Always 0, as no GL calls are made.
+//===========================================
+inline long Renderer::getGLCallsIssued() const {
+   return 0;
+}
+
+//===========================================
+// Renderer::getGLCallsElided
+//
+// Always 0, as no GL calls are made.
+//===========================================
+inline long Renderer::getGLCallsElided() const {
+   return 0;
+}
+
+//===========================================
+// Renderer::getFramesPresented
+//
+// Every frame is processed by tick(), so this is the number of calls to tick().
+//===========================================
+inline long long Renderer::getFramesPresented() const {
+   return m_framesPresented;
+}
+
+//===========================================
+// Renderer::getFramesDuplicated
+//
+// Always 0, as frames are never repeated.
+//===========================================
+inline long long Renderer::getFramesDuplicated() const {
+   return 0;
+}
+
+//===========================================
+// Renderer::setCullGuardBand
+//===========================================
+inline void Renderer::setCullGuardBand(float32_t margin) {
+   std::lock_guard<std::mutex> lock(m_drawMutex);
+
+   m_usrReqSettings.cullGuardBand = margin;
+   m_cullRectValid = false;
+}
+
+//===========================================
+// Renderer::setRenderOnChange
+//
+// Has no effect, as frames are only processed when tick() is called.
+//===========================================
+inline void Renderer::setRenderOnChange(bool) {}
+
+//===========================================
+// Renderer::setMaxFrameRate
+//
+// Has no effect, as frames are only processed when tick() is called.
+//===========================================
+inline void Renderer::setMaxFrameRate(int_t) {}
+
+//===========================================
+// Renderer::getProfiler
+//
+// There's no render thread, so the message and swap times are always 0.
+//===========================================
+inline RenderProfiler& Renderer::getProfiler() {
+   return m_profiler;
+}
+
+//===========================================
+// Renderer::getCommandStream
+//
+// The draw calls for the most recent frame, in order.
+//===========================================
+inline const std::vector<Renderer::command_t>& Renderer::getCommandStream() const {
+   return m_commands;
+}
+
+//===========================================
+// Renderer::getFrameChecksum
+//
+// Hash of everything that would have affected the most recent frame's
+// appearance: the background colour, the camera, and each model's state and
+// vertex data in draw order.
+//===========================================
+inline uint64_t Renderer::getFrameChecksum() const {
+   return m_checksum;
+}
+
+//===========================================
+// Renderer::getTexturesLoaded
+//
+// Number of textures currently loaded.
+//===========================================
+inline long Renderer::getTexturesLoaded() const {
+   return m_texturesLoaded;
+}
+
+//===========================================
+// Renderer::attachCamera
+//===========================================
+inline void Renderer::attachCamera(pCamera_t camera) {
+   m_camera = camera;
+}
+
+//===========================================
+// Renderer::getCamera
+//===========================================
+inline Camera& Renderer::getCamera() const {
+   return *m_camera;
+}
+
+//===========================================
+// Renderer::redirectDraws
+//===========================================
+inline void Renderer::redirectDraws(DrawList* list) {
+   m_drawRedirect = list;
+}
+
+
+}
+
+
+#endif /*!__RENDERER_HPP__*/
@@ -0,0 +1,148 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#ifndef __TEXTURE_HPP__
+#define __TEXTURE_HPP__
+
+
+#include <future>
+#include <cstdint>
+#include <boost/shared_ptr.hpp>
+#include "../../xml/xml.hpp"
+#include "../../definitions.hpp"
+#include "../../../pnglite/pnglite.h"
+#include "../../Asset.hpp"
+#include "../../Range.hpp"
+
+
+namespace Dodge {
+
+
+class Renderer;
+class TextureAtlas;
+
+// PNG/headless implementation
+//
+// The image is loaded so that its data is available, but nothing is uploaded. The handle is
+// allocated by the headless renderer and is ready immediately.
+//
+// A texture may be packed into a TextureAtlas, after which getHandle() refers to the atlas.
+// Texture sections (in pixels, relative to this texture) should then be converted with
+// mapSection() and texture coordinates computed from getAtlasWidth() and getAtlasHeight().
+class Texture : virtual public Asset {
+   friend class TextureAtlas;
+
+   public:
+      Texture(const XmlNode data);
+      Texture(const char* file);
+
+      virtual size_t getSize() const;
+      virtual Asset* clone() const;
+
+      inline int32_t getWidth() const;
+      inline int32_t getHeight() const;
+      inline const byte_t* getData() const;
+      inline const uint32_t& getHandle() const;
+      inline bool isLoaded() const;
+
+      inline bool isInAtlas() const;
+      inline int32_t getAtlasWidth() const;
+      inline int32_t getAtlasHeight() const;
+      Range mapSection(const Range& section) const;
+
+      virtual ~Texture();
+
+   private:
+      void constructTexture(const char* file);
+      void pngInit() const;
+      void setAtlas(uint32_t handle, int32_t w, int32_t h, int32_t x, int32_t y);
+
+      png_t m_png;
+      byte_t* m_data;
+      int32_t m_width;
+      int32_t m_height;
+      std::shared_future<uint32_t> m_handle;
+
+      // If the texture is in an atlas, m_atlasHandle is the atlas' handle and
+      // (m_atlasX, m_atlasY) is the top-left of the texture within it
+      uint32_t m_atlasHandle;
+      int32_t m_atlasW;
+      int32_t m_atlasH;
+      int32_t m_atlasX;
+      int32_t m_atlasY;
+
+      Renderer& m_renderer;
+};
+
+typedef boost::shared_ptr<Texture> pTexture_t;
+
+//===========================================
+// Texture::getWidth
+//===========================================
+inline int32_t Texture::getWidth() const {
+   return m_width;
+}
+
+//===========================================
+// Texture::getHeight
+//===========================================
+inline int32_t Texture::getHeight() const {
+   return m_height;
+}
+
+//===========================================
+// Texture::getData
+//===========================================
+inline const byte_t* Texture::getData() const {
+   return m_data;
+}
+
+//===========================================
+// Texture::getHandle
+//===========================================
+inline const uint32_t& Texture::getHandle() const {
+   return m_atlasHandle != 0 ? m_atlasHandle : m_handle.get();
+}
+
+//===========================================
+// Texture::isLoaded
+//
+// Returns true once the upload has completed (or failed), after which
+// getHandle() won't block.
+//===========================================
+inline bool Texture::isLoaded() const {
+   return m_handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+//===========================================
+// Texture::isInAtlas
+//===========================================
+inline bool Texture::isInAtlas() const {
+   return m_atlasHandle != 0;
+}
+
+//===========================================
+// Texture::getAtlasWidth
+//
+// Width of the texture referred to by getHandle()
+//===========================================
+inline int32_t Texture::getAtlasWidth() const {
+   return m_atlasHandle != 0 ? m_atlasW : m_width;
+}
+
+//===========================================
+// Texture::getAtlasHeight
+//
+// Height of the texture referred to by getHandle()
+//===========================================
+inline int32_t Texture::getAtlasHeight() const {
+   return m_atlasHandle != 0 ? m_atlasH : m_height;
+}
+
+
+}
+
+
+#endif
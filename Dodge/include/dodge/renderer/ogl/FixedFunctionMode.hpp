@@ -19,7 +19,7 @@ class FixedFunctionMode : public RenderMode {
       FixedFunctionMode();
 
       virtual void setActive();
-      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo);
+      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo, size_t vboOffset);
 
       virtual ~FixedFunctionMode() {}
 
@@ -3,6 +3,9 @@
 
 
 #include <cassert>
+#include <cstring>
+#include <map>
+#include <vector>
 #ifdef GLEW
    #include <GLEW/glew.h>
 #else
@@ -36,25 +39,54 @@ struct oglFeature_t {
 struct oglSupport_t {
    oglSupport_t()
       : shaders(true, CORE),
-        VBOs(true, CORE) {}
+        VBOs(true, CORE),
+        mapBufferRange(false),
+        instancing(false) {}
 
    oglFeature_t shaders;
    oglFeature_t VBOs;
+   oglFeature_t mapBufferRange;
+   oglFeature_t instancing;
 };
 
 
+// Calls that set GL state go through a shadow copy of that state, so calls
+// that wouldn't change anything are never made. All GL calls must be made
+// from the same thread, and state changed directly (bypassing the wrapper)
+// must be followed by a call to invalidateStateCache().
 class OglWrapper {
    public:
       void initialise(const oglSupport_t& supportedFeatures) {
          m_oglSupport = supportedFeatures;
+         invalidateStateCache();
       }
 
       inline const oglSupport_t& getSupportedFeatures() const;
 
+      void invalidateStateCache() const;
+
+      inline long getCallsIssued() const;
+      inline long getCallsElided() const;
+      inline long getProgramSwitches() const;
+      inline long getTextureSwitches() const;
+      inline void resetCallCounters() const;
+
+      inline void enable(GLenum cap) const;
+      inline void disable(GLenum cap) const;
+      inline void blendFunc(GLenum sfactor, GLenum dfactor) const;
+      inline void lineWidth(GLfloat width) const;
+      inline void bindTexture(GLenum target, GLuint texture) const;
+      inline void deleteTextures(GLsizei n, const GLuint* textures) const;
+
       inline void bindBuffer(GLenum target, GLuint buf) const;
       inline void genBuffers(GLsizei n, GLuint* bufs) const;
       inline void bufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) const;
+      inline void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) const;
       inline void deleteBuffers(GLsizei n, const GLuint* bufs) const;
+#ifdef GLEW
+      inline GLvoid* mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) const;
+      inline GLboolean unmapBuffer(GLenum target) const;
+#endif
 
 #ifndef GL_FIXED_PIPELINE
       inline GLuint createProgram() const;
@@ -74,12 +106,190 @@ class OglWrapper {
       inline void getShaderiv(GLuint shader, GLenum pname, GLint* params) const;
       inline void attachShader(GLuint program, GLuint shader) const;
       inline void getShaderInfoLog(GLuint shader, GLsizei maxLength, GLsizei* length, GLchar* infoLog) const;
+#ifdef GLEW
+      inline void vertexAttribDivisor(GLuint index, GLuint divisor) const;
+      inline void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount) const;
+#endif
 #endif
 
    private:
+      static const GLuint MAX_VERTEX_ATTRIBS = 16;
+
+      struct attribPointer_t {
+         bool valid;
+         GLuint buffer;
+         GLint size;
+         GLenum type;
+         GLboolean normalized;
+         GLsizei stride;
+         const GLvoid* pointer;
+      };
+
+      struct uniform_t {
+         uniform_t() : valid(false) {}
+
+         bool valid;
+         GLfloat value[16];
+      };
+
+      struct glState_t {
+         GLuint program;
+         GLuint arrayBuffer;
+         GLuint texture2d;
+         GLenum blendSrc;
+         GLenum blendDst;
+         GLfloat lineWidth;
+         std::map<GLenum, bool> caps;
+
+         // 0 = disabled, 1 = enabled, -1 = unknown
+         int attribEnabled[MAX_VERTEX_ATTRIBS];
+         attribPointer_t attribPointers[MAX_VERTEX_ATTRIBS];
+
+         // Uniform values, by program and location
+         std::map<GLuint, std::vector<uniform_t> > uniforms;
+         std::vector<uniform_t>* activeUniforms;
+      };
+
+      inline bool elide(bool unchanged) const;
+      inline bool uniformUnchanged(GLint location, const GLfloat* value, size_t size) const;
+
       static oglSupport_t m_oglSupport;
+      static glState_t m_state;
+      static long m_callsIssued;
+      static long m_callsElided;
+      static long m_programSwitches;
+      static long m_textureSwitches;
 };
 
+//===========================================
+// OglWrapper::elide
+//
+// Updates the call counters and returns true if the call should be skipped.
+//===========================================
+inline bool OglWrapper::elide(bool unchanged) const {
+   if (unchanged)
+      ++m_callsElided;
+   else
+      ++m_callsIssued;
+
+   return unchanged;
+}
+
+//===========================================
+// OglWrapper::getCallsIssued
+//
+// Number of state-setting calls passed on to GL since the counters were reset.
+//===========================================
+inline long OglWrapper::getCallsIssued() const {
+   return m_callsIssued;
+}
+
+//===========================================
+// OglWrapper::getCallsElided
+//
+// Number of state-setting calls skipped since the counters were reset.
+//===========================================
+inline long OglWrapper::getCallsElided() const {
+   return m_callsElided;
+}
+
+//===========================================
+// OglWrapper::getProgramSwitches
+//
+// Number of times the active program has changed since the counters were reset.
+//===========================================
+inline long OglWrapper::getProgramSwitches() const {
+   return m_programSwitches;
+}
+
+//===========================================
+// OglWrapper::getTextureSwitches
+//
+// Number of times the bound 2D texture has changed since the counters were reset.
+//===========================================
+inline long OglWrapper::getTextureSwitches() const {
+   return m_textureSwitches;
+}
+
+//===========================================
+// OglWrapper::resetCallCounters
+//===========================================
+inline void OglWrapper::resetCallCounters() const {
+   m_callsIssued = 0;
+   m_callsElided = 0;
+   m_programSwitches = 0;
+   m_textureSwitches = 0;
+}
+
+//===========================================
+// OglWrapper::enable
+//===========================================
+inline void OglWrapper::enable(GLenum cap) const {
+   std::map<GLenum, bool>::iterator i = m_state.caps.find(cap);
+   if (elide(i != m_state.caps.end() && i->second)) return;
+
+   glEnable(cap);
+   m_state.caps[cap] = true;
+}
+
+//===========================================
+// OglWrapper::disable
+//===========================================
+inline void OglWrapper::disable(GLenum cap) const {
+   std::map<GLenum, bool>::iterator i = m_state.caps.find(cap);
+   if (elide(i != m_state.caps.end() && !i->second)) return;
+
+   glDisable(cap);
+   m_state.caps[cap] = false;
+}
+
+//===========================================
+// OglWrapper::blendFunc
+//===========================================
+inline void OglWrapper::blendFunc(GLenum sfactor, GLenum dfactor) const {
+   if (elide(m_state.blendSrc == sfactor && m_state.blendDst == dfactor)) return;
+
+   glBlendFunc(sfactor, dfactor);
+   m_state.blendSrc = sfactor;
+   m_state.blendDst = dfactor;
+}
+
+//===========================================
+// OglWrapper::lineWidth
+//===========================================
+inline void OglWrapper::lineWidth(GLfloat width) const {
+   if (elide(m_state.lineWidth == width)) return;
+
+   glLineWidth(width);
+   m_state.lineWidth = width;
+}
+
+//===========================================
+// OglWrapper::bindTexture
+//===========================================
+inline void OglWrapper::bindTexture(GLenum target, GLuint texture) const {
+   if (target == GL_TEXTURE_2D) {
+      if (elide(m_state.texture2d == texture)) return;
+      m_state.texture2d = texture;
+
+      ++m_textureSwitches;
+   }
+
+   glBindTexture(target, texture);
+}
+
+//===========================================
+// OglWrapper::deleteTextures
+//
+// Deleting the bound texture reverts the binding to 0.
+//===========================================
+inline void OglWrapper::deleteTextures(GLsizei n, const GLuint* textures) const {
+   for (GLsizei i = 0; i < n; ++i)
+      if (textures[i] == m_state.texture2d) m_state.texture2d = 0;
+
+   glDeleteTextures(n, textures);
+}
+
 //===========================================
 // OglWrapper::getSupportedFeatures
 //===========================================
@@ -93,6 +303,11 @@ inline const oglSupport_t& OglWrapper::getSupportedFeatures() const {
 inline void OglWrapper::bindBuffer(GLenum target, GLuint buf) const {
    assert(m_oglSupport.VBOs.available);
 
+   if (target == GL_ARRAY_BUFFER) {
+      if (elide(m_state.arrayBuffer == buf)) return;
+      m_state.arrayBuffer = buf;
+   }
+
    switch (m_oglSupport.VBOs.nameScheme) {
       case CORE:  glBindBuffer(target, buf);       break;
 #ifdef GLEW
@@ -135,12 +350,60 @@ inline void OglWrapper::bufferData(GLenum target, GLsizeiptr size, const GLvoid*
    }
 }
 
+//===========================================
+// OglWrapper::bufferSubData
+//===========================================
+inline void OglWrapper::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) const {
+   assert(m_oglSupport.VBOs.available);
+
+   switch (m_oglSupport.VBOs.nameScheme) {
+      case CORE:  glBufferSubData(target, offset, size, data);       break;
+#ifdef GLEW
+      case ARB:   glBufferSubDataARB(target, offset, size, data);    break;
+#endif
+      default:
+         assert(false);
+   }
+}
+
+#ifdef GLEW
+//===========================================
+// OglWrapper::mapBufferRange
+//
+// ARB_map_buffer_range uses the core names.
+//===========================================
+inline GLvoid* OglWrapper::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) const {
+   assert(m_oglSupport.mapBufferRange.available);
+
+   return glMapBufferRange(target, offset, length, access);
+}
+
+//===========================================
+// OglWrapper::unmapBuffer
+//===========================================
+inline GLboolean OglWrapper::unmapBuffer(GLenum target) const {
+   assert(m_oglSupport.mapBufferRange.available);
+
+   switch (m_oglSupport.VBOs.nameScheme) {
+      case CORE:  return glUnmapBuffer(target);       break;
+      case ARB:   return glUnmapBufferARB(target);    break;
+      default:
+         assert(false);
+   }
+}
+#endif
+
 //===========================================
 // OglWrapper::deleteBuffers
+//
+// Deleting the bound buffer reverts the binding to 0.
 //===========================================
 inline void OglWrapper::deleteBuffers(GLsizei n, const GLuint* bufs) const {
    assert(m_oglSupport.VBOs.available);
 
+   for (GLsizei i = 0; i < n; ++i)
+      if (bufs[i] == m_state.arrayBuffer) m_state.arrayBuffer = 0;
+
    switch (m_oglSupport.VBOs.nameScheme) {
       case CORE:  glDeleteBuffers(n, bufs);       break;
 #ifdef GLEW
@@ -190,6 +453,13 @@ inline void OglWrapper::linkProgram(GLuint program) const {
 inline void OglWrapper::useProgram(GLuint program) const {
    assert(m_oglSupport.shaders.available);
 
+   if (elide(m_state.program == program)) return;
+
+   m_state.program = program;
+   m_state.activeUniforms = &m_state.uniforms[program];
+
+   ++m_programSwitches;
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glUseProgram(program);             break;
 #ifdef GLEW
@@ -238,6 +508,11 @@ inline GLint OglWrapper::getUniformLocation(GLuint program, const GLchar* name)
 inline void OglWrapper::enableVertexAttribArray(GLuint index) const {
    assert(m_oglSupport.shaders.available);
 
+   if (index < MAX_VERTEX_ATTRIBS) {
+      if (elide(m_state.attribEnabled[index] == 1)) return;
+      m_state.attribEnabled[index] = 1;
+   }
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glEnableVertexAttribArray(index);       break;
 #ifdef GLEW
@@ -254,6 +529,11 @@ inline void OglWrapper::enableVertexAttribArray(GLuint index) const {
 inline void OglWrapper::disableVertexAttribArray(GLuint index) const {
    assert(m_oglSupport.shaders.available);
 
+   if (index < MAX_VERTEX_ATTRIBS) {
+      if (elide(m_state.attribEnabled[index] == 0)) return;
+      m_state.attribEnabled[index] = 0;
+   }
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glDisableVertexAttribArray(index);       break;
 #ifdef GLEW
@@ -264,12 +544,41 @@ inline void OglWrapper::disableVertexAttribArray(GLuint index) const {
    }
 }
 
+//===========================================
+// OglWrapper::uniformUnchanged
+//
+// Compares value with the cached value of the uniform at location in the
+// current program, and updates the cache.
+//===========================================
+inline bool OglWrapper::uniformUnchanged(GLint location, const GLfloat* value, size_t size) const {
+   if (location < 0 || m_state.activeUniforms == NULL) return false;
+
+   std::vector<uniform_t>& uniforms = *m_state.activeUniforms;
+
+   if (static_cast<size_t>(location) >= uniforms.size())
+      uniforms.resize(location + 1);
+
+   uniform_t& u = uniforms[location];
+
+   if (u.valid && memcmp(u.value, value, size) == 0) return true;
+
+   memcpy(u.value, value, size);
+   u.valid = true;
+
+   return false;
+}
+
 //===========================================
 // OglWrapper::uniform1i
 //===========================================
 inline void OglWrapper::uniform1i(GLint location, GLint v0) const {
    assert(m_oglSupport.shaders.available);
 
+   GLfloat value[1];
+   memcpy(value, &v0, sizeof(GLint));
+
+   if (elide(uniformUnchanged(location, value, sizeof(GLint)))) return;
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glUniform1i(location, v0);       break;
 #ifdef GLEW
@@ -281,11 +590,14 @@ inline void OglWrapper::uniform1i(GLint location, GLint v0) const {
 }
 
 //===========================================
-// OglWrapper::uniform1i
+// OglWrapper::uniform4f
 //===========================================
 inline void OglWrapper::uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) const {
    assert(m_oglSupport.shaders.available);
 
+   GLfloat value[] = { v0, v1, v2, v3 };
+   if (elide(uniformUnchanged(location, value, sizeof(value)))) return;
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glUniform4f(location, v0, v1, v2, v3);       break;
 #ifdef GLEW
@@ -302,6 +614,21 @@ inline void OglWrapper::uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloa
 inline void OglWrapper::uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) const {
    assert(m_oglSupport.shaders.available);
 
+   // Only single, untransposed matrices are cached
+   if (count == 1 && transpose == GL_FALSE) {
+      if (elide(uniformUnchanged(location, value, 16 * sizeof(GLfloat)))) return;
+   }
+   else {
+      elide(false);
+
+      if (location >= 0 && m_state.activeUniforms != NULL) {
+         std::vector<uniform_t>& uniforms = *m_state.activeUniforms;
+
+         for (GLint i = location; i < location + count && static_cast<size_t>(i) < uniforms.size(); ++i)
+            uniforms[i].valid = false;
+      }
+   }
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glUniformMatrix4fv(location, count, transpose, value);       break;
 #ifdef GLEW
@@ -318,6 +645,28 @@ inline void OglWrapper::uniformMatrix4fv(GLint location, GLsizei count, GLboolea
 inline void OglWrapper::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer) const {
    assert(m_oglSupport.shaders.available);
 
+   if (index < MAX_VERTEX_ATTRIBS) {
+      attribPointer_t& p = m_state.attribPointers[index];
+
+      bool unchanged = p.valid
+         && p.buffer == m_state.arrayBuffer
+         && p.size == size
+         && p.type == type
+         && p.normalized == normalized
+         && p.stride == stride
+         && p.pointer == pointer;
+
+      if (elide(unchanged)) return;
+
+      p.valid = true;
+      p.buffer = m_state.arrayBuffer;
+      p.size = size;
+      p.type = type;
+      p.normalized = normalized;
+      p.stride = stride;
+      p.pointer = pointer;
+   }
+
    switch (m_oglSupport.shaders.nameScheme) {
       case CORE:  glVertexAttribPointer(index, size, type, normalized, stride, pointer);       break;
 #ifdef GLEW
@@ -443,6 +792,36 @@ inline void OglWrapper::getShaderInfoLog(GLuint shader, GLsizei maxLength, GLsiz
          assert(false);
    }
 }
+
+#ifdef GLEW
+//===========================================
+// OglWrapper::vertexAttribDivisor
+//===========================================
+inline void OglWrapper::vertexAttribDivisor(GLuint index, GLuint divisor) const {
+   assert(m_oglSupport.instancing.available);
+
+   switch (m_oglSupport.instancing.nameScheme) {
+      case CORE:  glVertexAttribDivisor(index, divisor);       break;
+      case ARB:   glVertexAttribDivisorARB(index, divisor);    break;
+      default:
+         assert(false);
+   }
+}
+
+//===========================================
+// OglWrapper::drawArraysInstanced
+//===========================================
+inline void OglWrapper::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount) const {
+   assert(m_oglSupport.instancing.available);
+
+   switch (m_oglSupport.instancing.nameScheme) {
+      case CORE:  glDrawArraysInstanced(mode, first, count, primcount);       break;
+      case ARB:   glDrawArraysInstancedARB(mode, first, count, primcount);    break;
+      default:
+         assert(false);
+   }
+}
+#endif
 #endif
 
 
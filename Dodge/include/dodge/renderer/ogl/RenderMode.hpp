@@ -18,7 +18,17 @@ namespace Dodge {
 class RenderMode {
    public:
       virtual void setActive() = 0;
-      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo) = 0;
+      // If vbo is non-zero, the model's vertices are read from it starting at vboOffset bytes
+      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo, size_t vboOffset) = 0;
+
+      // Draws numInstances copies of the model with a single call. The per-instance data is an array
+      // of modelInstance_t in instanceVbo, starting at instanceOffset. Returns false without drawing
+      // anything if the mode can't draw the model this way.
+      virtual bool sendInstances(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo, size_t vboOffset,
+         uint_t numInstances, GLuint instanceVbo, size_t instanceOffset) { return false; }
+
+      // Returns true if sendInstances() is able to draw the model
+      virtual bool canDrawInstanced(const IModel* model) const { return false; }
 
       virtual ~RenderMode() {}
 
@@ -21,16 +21,23 @@
 #include <cml/cml.h>
 #pragma GCC diagnostic pop
 #include <map>
+#include <vector>
 #include <queue>
 #include <cstring>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
-#include <boost/variant.hpp>
+#include <future>
 #include "Colour.hpp"
 #include "../Camera.hpp"
+#include "../DrawList.hpp"
 #include "../RendererException.hpp"
+#include "../RenderProfiler.hpp"
+#include "../ModelCache.hpp"
 #include "../../StackAllocator.hpp"
+#include "../../SpscQueue.hpp"
+#include "../../PayloadRing.hpp"
 #include "../../definitions.hpp"
 #include "../../../utils/Functor.hpp"
 #include "OglWrapper.hpp"
@@ -60,6 +67,9 @@ class Renderer {
       typedef byte_t textureData_t;
       typedef GLuint textureHandle_t;
 
+      // Becomes ready once a texture has been uploaded
+      typedef std::shared_future<textureHandle_t> textureFuture_t;
+
       enum mode_t {
          UNDEFINED,
          TEXTURED_ALPHA,
@@ -84,13 +94,32 @@ class Renderer {
       void bufferModel(IModel* model);
       void freeBufferedModel(IModel* model);
 
+      textureFuture_t loadTextureAsync(const textureData_t* texture, int_t width, int_t height);
       void loadTexture(const textureData_t* texture, int_t width, int_t height, textureHandle_t* handle);
       void unloadTexture(textureHandle_t handle);
 
       void draw(const IModel* model);
+      void submit(DrawList& list);
+
+      // While set, models drawn from the calling thread are recorded into
+      // list instead of the frame. Pass NULL to restore.
+      inline void redirectDraws(DrawList* list);
 #ifdef DEBUG
       inline long getFrameRate() const;
 #endif
+      inline long getDrawCalls() const;
+      inline long getDrawCallsSaved() const;
+      inline long getModelsSubmitted() const;
+      inline long getModelsCulled() const;
+      inline long getGLCallsIssued() const;
+      inline long getGLCallsElided() const;
+      inline long long getFramesPresented() const;
+      inline long long getFramesDuplicated() const;
+      inline void setCullGuardBand(float32_t margin);
+      inline void setRenderOnChange(bool b);
+      inline void setMaxFrameRate(int_t fps);
+      inline RenderProfiler& getProfiler();
+
       void loadSettingsFromFile(const std::string& file);
       void start(Functor<void, TYPELIST_0()> makeGLContextFunc, Functor<void, TYPELIST_0()> swapFunc);
       void stop();
@@ -98,6 +127,10 @@ class Renderer {
       //---------------------
 
    private:
+      static const size_t STREAM_BUFFER_SIZE = 1048576; // 1MB
+      static const size_t MSG_QUEUE_SIZE = 4096;
+      static const size_t MSG_PAYLOAD_SIZE = 4194304; // 4MB
+
       static void dummySwapFunc() {}
       static void dummyMakeGLContextFunc() {}
 
@@ -115,10 +148,18 @@ class Renderer {
       struct usrReqSettings_t {
          usrReqSettings_t()
             : fixedPipeline(false),
-              VBOs(true) {}
+              VBOs(true),
+              batching(true),
+              cullGuardBand(0.1f),
+              renderOnChange(false),
+              maxFrameRate(0) {}
 
          bool fixedPipeline;
          bool VBOs;
+         bool batching;
+         float32_t cullGuardBand;
+         bool renderOnChange;
+         int_t maxFrameRate;
       };
 
       struct msgTexHandleReq_t {
@@ -126,7 +167,8 @@ class Renderer {
          int_t w;
          int_t h;
 
-         textureHandle_t* retVal;
+         // Deleted by the render thread once fulfilled
+         std::promise<textureHandle_t>* retVal;
       };
 
       struct msgTexUnloadReq_t {
@@ -143,24 +185,25 @@ class Renderer {
       };
 
       struct msgDestroyVbo_t {
-         GLuint handle;
+         long slot;
       };
 
-      typedef boost::variant<
-         msgTexHandleReq_t,
-         msgTexUnloadReq_t,
-         msgVpResizeReq_t,
-         msgConstructVbo_t,
-         msgDestroyVbo_t
-         // ...
-      > msgData_t;
-
+      // Messages are POD so they can be passed through an SpscQueue. Any
+      // variable-sized data lives in m_msgPayloads until the message has
+      // been processed.
       struct Message {
-         Message(msgType_t type_, msgData_t data_)
-            : type(type_), data(data_) {}
-
          msgType_t type;
-         msgData_t data;
+         bool hasPayload;
+         PayloadRing::marker_t payloadEnd;
+
+         union {
+            msgTexHandleReq_t texHandleReq;
+            msgTexUnloadReq_t texUnloadReq;
+            msgVpResizeReq_t vpResizeReq;
+            msgConstructVbo_t constructVbo;
+            msgDestroyVbo_t destroyVbo;
+            // ...
+         } data;
       };
 
       struct renderState_t {
@@ -175,13 +218,23 @@ class Renderer {
          std::unique_ptr<SceneGraph> sceneGraph;
          cml::matrix44f_c P;
          Colour bgColour;
+
+         // Main thread statistics, gathered while the profiler is enabled
+         RenderProfiler::frameStats_t stats;
       };
 
       static Renderer* m_instance;
+      static THREAD_LOCAL DrawList* m_drawRedirect;
 
       //-----Main Thread-----
       void checkForErrors();
-      void queueMsg(Message msg);
+      void wakeRenderThread();
+      bool queueMsg(const Message& msg);
+      void* allocMsgPayload(size_t size, Message& msg);
+      void addToFrame(const IModel* model);
+      void mergeDrawLists();
+      bool isVisible(const IModel* model);
+      size_t insertModel(const IModel* model);
       //---------------------
 
       //----Render Thread----
@@ -190,10 +243,19 @@ class Renderer {
       void init();
       void clear();
       void constructVbo(IModel* model);
-      void destroyVbo(GLuint handle);
+      size_t streamVertexData(const void* data, size_t size);
+      void destroyVbo(long slot);
       void setMode(mode_t mode);
+      void drawModel(const IModel* model);
+      uint_t drawBatch();
+      bool drawInstanced();
+      bool canBatch(const IModel* a, const IModel* b) const;
+      IModel* constructTexturedBatch(uint_t nVerts);
+      IModel* constructNonTexturedBatch(uint_t nVerts);
       void constructRenderModes();
       void processMessage(const Message& msg);
+      void discardMessages();
+      void awaitStop();
       textureHandle_t loadGLTexture(const textureData_t* texture, int_t w, int_t h);
 #ifdef DEBUG
       void computeFrameRate();
@@ -208,8 +270,21 @@ class Renderer {
       usrReqSettings_t m_usrReqSettings;
       oglSupport_t m_oglSupport;
 
-      std::map<long, GLuint> m_vboMap;
-      std::mutex m_vboMapMutex; // TODO: Make thread-safe map container
+      struct vbo_t {
+         GLuint handle;
+         long modelId;
+      };
+
+      // Buffered models' VBOs, indexed by IModel::m_bufferSlot. Owned by the
+      // render thread, and only changed in response to MSG_CONSTRUCT_VBO and
+      // MSG_DESTROY_VBO, so lookups need no lock. An entry only belongs to a
+      // model if its id matches, as slots are reused.
+      std::vector<vbo_t> m_vbos;
+
+      // Slots given back by freeBufferedModel(), to be reused before new
+      // ones are handed out. Guarded by m_msgQueueMutex.
+      std::vector<long> m_freeVboSlots;
+      long m_nextVboSlot;
 
       std::map<mode_t, RenderMode*> m_renderModes;
       RenderMode* m_activeRenderMode;
@@ -222,17 +297,68 @@ class Renderer {
       int m_idxRender;
       int m_idxUpdate;
       mutable std::mutex m_stateChangeMutex;
+      std::mutex m_drawMutex;
       std::atomic<long long> m_frameNumber;
 
+      // Lists submitted since the last tick
+      std::vector<DrawList*> m_drawLists;
+
+      // Copies of the models drawn, shared between render states
+      ModelCache m_modelCache;
+
+      // Signalled, with m_stateChangeMutex, when the render thread may have
+      // something to do: a new frame, a message, or a request to stop.
+      std::condition_variable m_cvRender;
+
+      // True while the render thread is waiting on m_cvRender for a new frame
+      // or a message, so queueing a message only needs to notify it then.
+      std::atomic<bool> m_renderThreadWaiting;
+
+      // Set by the render thread when the current frame must be drawn again,
+      // even if the main thread hasn't produced a new one.
+      bool m_redrawRequired;
+
+      std::atomic<long long> m_framesPresented;
+      std::atomic<long long> m_framesDuplicated;
+
+      // Region outside of which models are culled, as (x1, y1, x2, y2). Taken
+      // from the camera on the first call to draw() each frame.
+      float32_t m_cullRect[4];
+      bool m_cullRectValid;
+
+      long m_frameModelsSubmitted;
+      long m_frameModelsCulled;
+      std::atomic<long> m_modelsSubmitted;
+      std::atomic<long> m_modelsCulled;
+
+      // Consecutive models that can be drawn together
+      std::vector<const IModel*> m_batch;
+      StackAllocator m_batchSpace;
+
+      // Ring buffer for vertex data that has no VBO of its own
+      GLuint m_streamVbo;
+      size_t m_streamBufferSize;
+      size_t m_streamOffset;
+
+      std::atomic<long> m_drawCalls;
+      std::atomic<long> m_drawCallsSaved;
+      std::atomic<long> m_glCallsIssued;
+      std::atomic<long> m_glCallsElided;
+
       pCamera_t m_camera;
 
       std::atomic<bool> m_running;
       std::thread* m_thread;
 
-      std::vector<Message> m_msgQueue;
-      StackAllocator m_scratchSpace;
+      // Written by the main thread(s) and read by the render thread. Only
+      // producers take m_msgQueueMutex, to serialise access between themselves.
+      SpscQueue<Message> m_msgQueue;
+      PayloadRing m_msgPayloads;
       mutable std::mutex m_msgQueueMutex;
-      std::atomic<bool> m_msgQueueEmpty;
+
+      // Set by stop() once the render thread has exited. Any messages queued
+      // after that are dropped. Guarded by m_msgQueueMutex.
+      bool m_stopped;
 
       exceptionWrapper_t m_exception;
       std::atomic<bool> m_errorPending;
@@ -241,6 +367,8 @@ class Renderer {
       std::atomic<long> m_frameRate;
 #endif
 
+      RenderProfiler m_profiler;
+
       OglWrapper m_gl;
 };
 
@@ -253,6 +381,125 @@ inline long Renderer::getFrameRate() const {
 }
 #endif
 
+//===========================================
+// Renderer::getDrawCalls
+//
+// Number of draw calls issued for the most recently rendered frame.
+//===========================================
+inline long Renderer::getDrawCalls() const {
+   return m_drawCalls;
+}
+
+//===========================================
+// Renderer::getDrawCallsSaved
+//
+// Number of draw calls avoided by batching in the most recently rendered frame.
+//===========================================
+inline long Renderer::getDrawCallsSaved() const {
+   return m_drawCallsSaved;
+}
+
+//===========================================
+// Renderer::getModelsSubmitted
+//
+// Number of models that passed culling in the most recently completed frame.
+//===========================================
+inline long Renderer::getModelsSubmitted() const {
+   return m_modelsSubmitted;
+}
+
+//===========================================
+// Renderer::getModelsCulled
+//
+// Number of models rejected by culling in the most recently completed frame.
+//===========================================
+inline long Renderer::getModelsCulled() const {
+   return m_modelsCulled;
+}
+
+//===========================================
+// Renderer::getGLCallsIssued
+//
+// Number of state-setting GL calls made in the most recently rendered frame.
+//===========================================
+inline long Renderer::getGLCallsIssued() const {
+   return m_glCallsIssued;
+}
+
+//===========================================
+// Renderer::getGLCallsElided
+//
+// Number of state-setting GL calls skipped in the most recently rendered
+// frame because they wouldn't have changed anything.
+//===========================================
+inline long Renderer::getGLCallsElided() const {
+   return m_glCallsElided;
+}
+
+//===========================================
+// Renderer::getFramesPresented
+//
+// Number of frames displayed that were newly produced by the main thread.
+//===========================================
+inline long long Renderer::getFramesPresented() const {
+   return m_framesPresented;
+}
+
+//===========================================
+// Renderer::getFramesDuplicated
+//
+// Number of frames displayed that repeated the previous frame's state,
+// because the main thread hadn't finished a new one.
+//===========================================
+inline long long Renderer::getFramesDuplicated() const {
+   return m_framesDuplicated;
+}
+
+//===========================================
+// Renderer::setCullGuardBand
+//
+// Models are only culled if they lie further than this outside the camera's
+// view, so they aren't lost if the camera moves before the frame is rendered.
+//===========================================
+inline void Renderer::setCullGuardBand(float32_t margin) {
+   std::lock_guard<std::mutex> lock(m_drawMutex);
+
+   m_usrReqSettings.cullGuardBand = margin;
+   m_cullRectValid = false;
+}
+
+//===========================================
+// Renderer::setRenderOnChange
+//
+// If true, the render thread sleeps until tick() delivers a new frame
+// instead of redrawing the previous one.
+//===========================================
+inline void Renderer::setRenderOnChange(bool b) {
+   {
+      std::lock_guard<std::mutex> lock(m_stateChangeMutex);
+      m_usrReqSettings.renderOnChange = b;
+   }
+
+   m_cvRender.notify_one();
+}
+
+//===========================================
+// Renderer::setMaxFrameRate
+//
+// Limits the rate at which frames are drawn. A value of 0 means no limit.
+//===========================================
+inline void Renderer::setMaxFrameRate(int_t fps) {
+   std::lock_guard<std::mutex> lock(m_stateChangeMutex);
+   m_usrReqSettings.maxFrameRate = fps > 0 ? fps : 0;
+}
+
+//===========================================
+// Renderer::getProfiler
+//===========================================
+inline RenderProfiler& Renderer::getProfiler() {
+   return m_profiler;
+}
+
 //===========================================
 // Renderer::attachCamera
 //===========================================
@@ -267,6 +514,13 @@ inline Camera& Renderer::getCamera() const {
    return *m_camera;
 }
 
+//===========================================
+// Renderer::redirectDraws
+//===========================================
+inline void Renderer::redirectDraws(DrawList* list) {
+   m_drawRedirect = list;
+}
+
 
 }
 
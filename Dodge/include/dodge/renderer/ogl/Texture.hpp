@@ -17,20 +17,32 @@
       #include <GLES2/gl2.h>
    #endif
 #endif
+#include <future>
 #include <boost/shared_ptr.hpp>
 #include "../../xml/xml.hpp"
 #include "../../definitions.hpp"
 #include "../../../pnglite/pnglite.h"
 #include "../../Asset.hpp"
+#include "../../Range.hpp"
 
 
 namespace Dodge {
 
 
 class Renderer;
+class TextureAtlas;
 
 // PNG/OGLES2 implementation
+//
+// The texture is uploaded asynchronously. getHandle() blocks until the upload has completed;
+// isLoaded() can be used to avoid this.
+//
+// A texture may be packed into a TextureAtlas, after which getHandle() refers to the atlas.
+// Texture sections (in pixels, relative to this texture) should then be converted with
+// mapSection() and texture coordinates computed from getAtlasWidth() and getAtlasHeight().
 class Texture : virtual public Asset {
+   friend class TextureAtlas;
+
    public:
       Texture(const XmlNode data);
       Texture(const char* file);
@@ -42,18 +54,33 @@ class Texture : virtual public Asset {
       inline GLint getHeight() const;
       inline const byte_t* getData() const;
       inline const GLuint& getHandle() const;
+      inline bool isLoaded() const;
+
+      inline bool isInAtlas() const;
+      inline GLint getAtlasWidth() const;
+      inline GLint getAtlasHeight() const;
+      Range mapSection(const Range& section) const;
 
       virtual ~Texture();
 
    private:
       void constructTexture(const char* file);
       void pngInit() const;
+      void setAtlas(GLuint handle, GLint w, GLint h, GLint x, GLint y);
 
       png_t m_png;
       byte_t* m_data;
       GLint m_width;
       GLint m_height;
-      GLuint m_handle;
+      std::shared_future<GLuint> m_handle;
+
+      // If the texture is in an atlas, m_atlasHandle is the atlas' handle and
+      // (m_atlasX, m_atlasY) is the top-left of the texture within it
+      GLuint m_atlasHandle;
+      GLint m_atlasW;
+      GLint m_atlasH;
+      GLint m_atlasX;
+      GLint m_atlasY;
 
       Renderer& m_renderer;
 };
@@ -85,7 +112,42 @@ inline const byte_t* Texture::getData() const {
 // Texture::getHandle
 //===========================================
 inline const GLuint& Texture::getHandle() const {
-   return m_handle;
+   return m_atlasHandle != 0 ? m_atlasHandle : m_handle.get();
+}
+
+//===========================================
+// Texture::isLoaded
+//
+// Returns true once the upload has completed (or failed), after which
+// getHandle() won't block.
+//===========================================
+inline bool Texture::isLoaded() const {
+   return m_handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+//===========================================
+// Texture::isInAtlas
+//===========================================
+inline bool Texture::isInAtlas() const {
+   return m_atlasHandle != 0;
+}
+
+//===========================================
+// Texture::getAtlasWidth
+//
+// Width of the GL texture referred to by getHandle()
+//===========================================
+inline GLint Texture::getAtlasWidth() const {
+   return m_atlasHandle != 0 ? m_atlasW : m_width;
+}
+
+//===========================================
+// Texture::getAtlasHeight
+//
+// Height of the GL texture referred to by getHandle()
+//===========================================
+inline GLint Texture::getAtlasHeight() const {
+   return m_atlasHandle != 0 ? m_atlasH : m_height;
 }
 
 
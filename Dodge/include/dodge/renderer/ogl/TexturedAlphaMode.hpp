@@ -20,12 +20,16 @@ class TexturedAlphaMode : public RenderMode {
       TexturedAlphaMode();
 
       virtual void setActive();
-      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo);
+      virtual void sendData(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo, size_t vboOffset);
+      virtual bool sendInstances(const IModel* model, const cml::matrix44f_c& projMat, GLuint vbo, size_t vboOffset,
+         uint_t numInstances, GLuint instanceVbo, size_t instanceOffset);
+      virtual bool canDrawInstanced(const IModel* model) const;
 
       virtual ~TexturedAlphaMode() {}
 
    private:
       bool isSupported(const IModel* model) const;
+      void constructInstancedProgram();
 
       GLint m_id;
 
@@ -36,6 +40,17 @@ class TexturedAlphaMode : public RenderMode {
       GLint m_locTexCoord;
       GLint m_locMV;
       GLint m_locP;
+      GLint m_locTexRect;
+
+      // Program for instanced drawing; 0 if unsupported
+      GLint m_instancedId;
+
+      GLint m_locInstPosition;
+      GLint m_locInstTexCoord;
+      GLint m_locInstMV[4];
+      GLint m_locInstColour;
+      GLint m_locInstTexRect;
+      GLint m_locInstP;
 
       OglWrapper m_gl;
 };
@@ -3,7 +3,9 @@
  * Date: 2012
  */
 
-#ifdef WIN32
+#ifdef HEADLESS
+   #include "headless/Renderer.hpp"
+#elif defined WIN32
    #include "ogl/Renderer.hpp"
 #else
    #include "ogl/Renderer.hpp"
@@ -0,0 +1,168 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <algorithm>
+#include <ActivityManager.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// ActivityManager::ActivityManager
+//===========================================
+ActivityManager::ActivityManager(float32_t activationMargin, float32_t deactivationMargin)
+   : m_activationMargin(activationMargin),
+     m_deactivationMargin(deactivationMargin) {
+
+   if (deactivationMargin < activationMargin)
+      throw Exception("Error constructing ActivityManager; Deactivation margin must be at least as large as activation margin", __FILE__, __LINE__);
+}
+
+//===========================================
+// ActivityManager::handleOrder
+//===========================================
+bool ActivityManager::handleOrder(const pEntity_t& a, const pEntity_t& b) {
+   return a->getHandle() < b->getHandle();
+}
+
+//===========================================
+// ActivityManager::findActive
+//
+// Returns m_activeList.end() if the entity isn't active.
+//===========================================
+vector<pEntity_t>::iterator ActivityManager::findActive(const pEntity_t& entity) {
+   vector<pEntity_t>::iterator i = lower_bound(m_activeList.begin(), m_activeList.end(), entity, handleOrder);
+   return i != m_activeList.end() && *i == entity ? i : m_activeList.end();
+}
+
+//===========================================
+// ActivityManager::addEntity
+//
+// Entities start dormant and are activated on the next call to update().
+//===========================================
+void ActivityManager::addEntity(pEntity_t entity) {
+   if (findActive(entity) != m_activeList.end()) return;
+
+   m_dormant.insert(entity);
+   entity->setDormant(true);
+}
+
+//===========================================
+// ActivityManager::removeEntity
+//
+// The entity is left active.
+//===========================================
+void ActivityManager::removeEntity(pEntity_t entity) {
+   vector<pEntity_t>::iterator i = findActive(entity);
+
+   if (i != m_activeList.end()) {
+      m_activeIdx.erase(m_activeIdx.begin() + (i - m_activeList.begin()));
+      m_activeList.erase(i);
+   }
+   else if (m_dormant.erase(entity) > 0) {
+      entity->setDormant(false);
+   }
+}
+
+//===========================================
+// ActivityManager::removeAll
+//===========================================
+void ActivityManager::removeAll() {
+   for (set<pEntity_t>::iterator i = m_dormant.begin(); i != m_dormant.end(); ++i)
+      (*i)->setDormant(false);
+
+   m_dormant.clear();
+   m_activeList.clear();
+   m_activeIdx.clear();
+}
+
+//===========================================
+// ActivityManager::rebuildActiveIndices
+//===========================================
+void ActivityManager::rebuildActiveIndices() {
+   m_activeIdx.resize(m_activeList.size());
+
+   for (uint_t i = 0; i < m_activeList.size(); ++i)
+      m_activeIdx[i] = m_activeList[i]->getTransformIndex();
+}
+
+//===========================================
+// ActivityManager::update
+//===========================================
+void ActivityManager::update(const Camera& camera) {
+   Vec2f pos = camera.getTranslation();
+   Vec2f size = camera.getViewSize();
+
+   Vec2f a(m_activationMargin, m_activationMargin);
+   Vec2f d(m_deactivationMargin, m_deactivationMargin);
+
+   Range inner(pos - a, size + a * 2.f);
+   Range outer(pos - d, size + d * 2.f);
+
+   // Deactivate entities that have left the outer region, keeping the rest
+   // in order
+   uint_t n = 0;
+   for (uint_t i = 0; i < m_activeList.size(); ++i) {
+      TransformStore::index_t idx = m_activeIdx[i];
+
+      bool inside = idx != TransformStore::NULL_INDEX
+         ? m_transformStore.boundaryOverlaps(idx, outer.getPosition(), outer.getSize())
+         : outer.overlaps(m_activeList[i]->getBoundary());
+
+      if (!inside) {
+         m_activeList[i]->setDormant(true);
+         m_dormant.insert(m_activeList[i]);
+      }
+      else {
+         if (n != i) {
+            m_activeList[n] = m_activeList[i];
+            m_activeIdx[n] = idx;
+         }
+         ++n;
+      }
+   }
+   m_activeList.resize(n);
+   m_activeIdx.resize(n);
+
+   // Activate dormant entities that have entered the inner region
+   if (!m_dormant.empty()) {
+      m_scratch.clear();
+      m_worldSpace.getEntities(inner, m_scratch);
+
+      for (uint_t i = 0; i < m_scratch.size(); ++i) {
+         const pEntity_t& entity = m_scratch[i];
+
+         if (!inner.overlaps(entity->getBoundary())) continue;
+
+         set<pEntity_t>::iterator it = m_dormant.find(entity);
+         if (it != m_dormant.end()) {
+            m_dormant.erase(it);
+            m_activated.push_back(entity);
+            entity->setDormant(false);
+         }
+      }
+
+      m_scratch.clear();
+   }
+
+   if (!m_activated.empty()) {
+      sort(m_activated.begin(), m_activated.end(), handleOrder);
+
+      uint_t mid = m_activeList.size();
+      m_activeList.insert(m_activeList.end(), m_activated.begin(), m_activated.end());
+      inplace_merge(m_activeList.begin(), m_activeList.begin() + mid, m_activeList.end(), handleOrder);
+
+      m_activated.clear();
+      rebuildActiveIndices();
+   }
+}
+
+
+}
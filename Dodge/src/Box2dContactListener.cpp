@@ -17,8 +17,8 @@ void Box2dContactListener::BeginContact(b2Contact* contact) {
       Entity* entA = reinterpret_cast<Entity*>(udA);
       Entity* entB = reinterpret_cast<Entity*>(udB);
 
-      EEvent* event1 = new EEntityCollision(true, entA->getSharedPtr(), entB->getSharedPtr());
-      EEvent* event2 = new EEntityCollision(true, entB->getSharedPtr(), entA->getSharedPtr());
+      EEvent* event1 = new EEntityCollision(true, entA->getHandle(), entB->getHandle());
+      EEvent* event2 = new EEntityCollision(true, entB->getHandle(), entA->getHandle());
 
       entA->onEvent(event1);
       entB->onEvent(event2);
@@ -38,8 +38,8 @@ void Box2dContactListener::EndContact(b2Contact* contact) {
       Entity* entA = reinterpret_cast<Entity*>(udA);
       Entity* entB = reinterpret_cast<Entity*>(udB);
 
-      EEvent* event1 = new EEntityCollision(false, entA->getSharedPtr(), entB->getSharedPtr());
-      EEvent* event2 = new EEntityCollision(false, entB->getSharedPtr(), entA->getSharedPtr());
+      EEvent* event1 = new EEntityCollision(false, entA->getHandle(), entB->getHandle());
+      EEvent* event2 = new EEntityCollision(false, entB->getHandle(), entA->getHandle());
 
       entA->onEvent(event1);
       entB->onEvent(event2);
@@ -7,6 +7,7 @@
 #include <Box2dPhysics.hpp>
 #include <Timer.hpp>
 #include <KvpParser.hpp>
+#include <EntityScheduler.hpp>
 #include <StringId.hpp>
 #include <utils/Functor.hpp>
 #include <math/fAreEqual.hpp>
@@ -25,6 +26,7 @@ int Box2dPhysics::m_v_iterations = 6;
 int Box2dPhysics::m_p_iterations = 4;
 EventManager Box2dPhysics::m_eventManager;
 set<long> Box2dPhysics::m_ignore;
+mutex Box2dPhysics::m_ignoreMutex;
 b2Vec2 Box2dPhysics::m_gravity = b2Vec2(0.f, -9.8f);
 b2World Box2dPhysics::m_world = b2World(m_gravity);
 Box2dContactListener Box2dPhysics::m_contactListener;
@@ -297,6 +299,13 @@ void Box2dPhysics::makeStatic() {
    constructBody();
 }
 
+//===========================================
+// Box2dPhysics::setAwake
+//===========================================
+void Box2dPhysics::setAwake(bool b) {
+   if (m_init) m_body->SetAwake(b);
+}
+
 //===========================================
 // Box2dPhysics::loadSettings
 //===========================================
@@ -338,12 +347,18 @@ void Box2dPhysics::onEvent(const EEvent* event) {
       && event->getType() != entityShapeStr
       && event->getType() != entityTranslationStr) return;
 
-   if (m_ignore.find(event->getId()) == m_ignore.end()) {
-      updatePos(event);
-   }
-   else {
-      m_ignore.erase(event->getId());
+   bool ignore = false;
+   {
+      lock_guard<mutex> lock(m_ignoreMutex);
+
+      set<long>::iterator it = m_ignore.find(event->getId());
+      if (it != m_ignore.end()) {
+         m_ignore.erase(it);
+         ignore = true;
+      }
    }
+
+   if (!ignore) updatePos(event);
 }
 
 //===========================================
@@ -357,6 +372,10 @@ void Box2dPhysics::updatePos(const EEvent* ev) {
    if (!m_init)
       throw PhysicsException("Instance of Box2dPhysics is not initialised", __FILE__, __LINE__);
 
+   // Box2D isn't thread-safe
+   if (EntityScheduler::inParallelSection())
+      throw PhysicsException("Error updating physics body; Bodies can't be moved during a parallel update or draw", __FILE__, __LINE__);
+
    if (ev->getType() == entityTranslationStr) {
       const EEntityTranslation* event = static_cast<const EEntityTranslation*>(ev);
 
@@ -428,9 +447,13 @@ void Box2dPhysics::update() {
       EEvent* event2 = new EEntityTranslation(m_entity->getSharedPtr(), oldTransl, oldTransl_abs, m_entity->getTranslation(), m_entity->getTranslation_abs());
       EEvent* event3 = new EEntityRotation(m_entity->getSharedPtr(), oldRot, oldRot_abs, m_entity->getRotation(), m_entity->getRotation_abs());
 
-      m_ignore.insert(event1->getId());
-      m_ignore.insert(event2->getId());
-      m_ignore.insert(event3->getId());
+      {
+         lock_guard<mutex> lock(m_ignoreMutex);
+
+         m_ignore.insert(event1->getId());
+         m_ignore.insert(event2->getId());
+         m_ignore.insert(event3->getId());
+      }
 
       m_entity->onEvent(event1);
       m_entity->onEvent(event2);
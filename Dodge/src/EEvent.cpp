@@ -13,8 +13,9 @@ using namespace std;
 namespace Dodge {
 
 
-long EEvent::m_nextId = 0;
+atomic<long> EEvent::m_nextId(0);
 StackAllocator EEvent::m_stack = StackAllocator(EEvent::STACK_SIZE);
+mutex EEvent::m_stackMutex;
 
 
 //===========================================
@@ -28,7 +29,11 @@ void* EEvent::operator new(size_t size) {
       void* p = ::operator new(size);
       if (p) return p;
 #else
+      // Events may be raised from EntityScheduler's worker threads
+      m_stackMutex.lock();
       void* p = m_stack.alloc(size);
+      m_stackMutex.unlock();
+
       if (p) return p;
 #endif
       new_handler globalHandler = set_new_handler(0);
@@ -11,6 +11,7 @@
 #include <AssetManager.hpp>
 #include <globals.hpp>
 #include <ShapeFactory.hpp>
+#include <EntityRegistry.hpp>
 
 
 using namespace std;
@@ -20,6 +21,7 @@ namespace Dodge {
 
 
 EventManager Entity::m_eventManager = EventManager();
+TransformStore Entity::m_transformStore = TransformStore();
 int Entity::m_count = 0;
 
 
@@ -80,11 +82,17 @@ void Entity::dbg_print(std::ostream& out, int tab) const {
 Entity::Entity(const XmlNode data)
    : Asset(internString("Entity")),
      m_silent(false),
+     m_dormant(false),
      m_parent(NULL) {
 
    AssetManager assetManager;
    ShapeFactory shapeFactory;
 
+   EntityRegistry registry;
+
+   m_transformIdx = m_transformStore.allocate(this);
+   m_handle = registry.add(this);
+
    try {
       setSilent(true);
 
@@ -110,9 +118,6 @@ Entity::Entity(const XmlNode data)
       XML_ATTR_CHECK(attr, z);
       m_z = attr.getFloat();
 
-      // So that no Z values are 'exactly' equal
-      m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
-
       attr = attr.nextAttribute();
       XML_ATTR_CHECK(attr, rot);
       float32_t rot = attr.getFloat();
@@ -167,6 +172,9 @@ Entity::Entity(const XmlNode data)
       ++m_count;
    }
    catch (XmlException& e) {
+      m_transformStore.release(m_transformIdx);
+      registry.remove(m_handle);
+
       e.prepend("Error parsing XML for instance of class Entity; ");
       throw;
    }
@@ -182,6 +190,7 @@ Entity::Entity(long name, long type)
      m_name(name),
      m_type(type),
      m_silent(false),
+     m_dormant(false),
      m_scale(1.f, 1.f),
      m_transl(0.f, 0.f),
      m_z(1),
@@ -189,8 +198,11 @@ Entity::Entity(long name, long type)
      m_lineWidth(0),
      m_parent(NULL) {
 
-   // So that no Z values are 'exactly' equal
-   m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
+   EntityRegistry registry;
+   m_handle = registry.add(this);
+
+   m_transformIdx = m_transformStore.allocate(this);
+   syncTransformStore();
 
    ++m_count;
 }
@@ -202,6 +214,7 @@ Entity::Entity(long type)
    : Asset(internString("Entity")),
      m_type(type),
      m_silent(false),
+     m_dormant(false),
      m_scale(1.f, 1.f),
      m_transl(0.f, 0.f),
      m_z(1),
@@ -209,11 +222,14 @@ Entity::Entity(long type)
      m_lineWidth(0),
      m_parent(NULL) {
 
-   // So that no Z values are 'exactly' equal
-   m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
-
    m_name = generateName();
 
+   EntityRegistry registry;
+   m_handle = registry.add(this);
+
+   m_transformIdx = m_transformStore.allocate(this);
+   syncTransformStore();
+
    ++m_count;
 }
 
@@ -225,11 +241,18 @@ Entity::Entity(long type)
 Entity::Entity(const Entity& copy)
    : Asset(internString("Entity")),
      m_silent(false),
+     m_dormant(false),
      m_parent(NULL) {
 
    deepCopy(copy);
    m_name = generateName();
 
+   EntityRegistry registry;
+   m_handle = registry.add(this);
+
+   m_transformIdx = m_transformStore.allocate(this);
+   syncTransformStore();
+
    ++m_count;
 }
 
@@ -241,11 +264,18 @@ Entity::Entity(const Entity& copy)
 Entity::Entity(const Entity& copy, long name)
    : Asset(internString("Entity")),
      m_silent(false),
+     m_dormant(false),
      m_parent(NULL) {
 
    deepCopy(copy);
    m_name = name;
 
+   EntityRegistry registry;
+   m_handle = registry.add(this);
+
+   m_transformIdx = m_transformStore.allocate(this);
+   syncTransformStore();
+
    ++m_count;
 }
 
@@ -265,9 +295,6 @@ void Entity::deepCopy(const Entity& copy) {
    m_z = copy.m_z;
    m_rot = copy.m_rot;
 
-   // So that no Z values are 'exactly' equal
-   m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
-
    if (copy.m_shape)
       m_shape = unique_ptr<Shape>(dynamic_cast<Shape*>(copy.m_shape->clone()));
 
@@ -337,9 +364,6 @@ void Entity::assignData(const XmlNode data) {
       if (!attr.isNull() && attr.name() == "z") {
          m_z = attr.getFloat();
 
-         // So that no Z values are 'exactly' equal
-         m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
-
          attr = attr.nextAttribute();
       }
 
@@ -416,6 +440,18 @@ void Entity::draw() const {
    }
 }
 
+//===========================================
+// Entity::getModels
+//===========================================
+void Entity::getModels(vector<IModel*>& models) const {
+   if (m_shape) {
+      Vec2f pos = getTranslation_abs();
+      m_shape->setRenderTransform(pos.x, pos.y, m_z);
+
+      m_shape->getModels(models);
+   }
+}
+
 //===========================================
 // Entity::setParent
 //===========================================
@@ -471,8 +507,8 @@ void Entity::removeChild(pEntity_t child) {
 void Entity::setZ(float32_t z) {
    m_z = z;
 
-   // So that no Z values are 'exactly' equal
-   m_z += 0.1f * static_cast<float32_t>(rand()) / static_cast<float32_t>(RAND_MAX);
+   if (m_transformIdx != TransformStore::NULL_INDEX)
+      m_transformStore.setZ(m_transformIdx, m_z);
 }
 
 //===========================================
@@ -504,6 +540,22 @@ void Entity::recomputeBoundary() {
 
    m_boundary.setPosition(getTranslation_abs() + min);
    m_boundary.setSize(max - min);
+
+   syncTransformStore();
+}
+
+//===========================================
+// Entity::syncTransformStore
+//
+// Called whenever the entity's transform or boundary changes.
+//===========================================
+void Entity::syncTransformStore() {
+   if (m_transformIdx == TransformStore::NULL_INDEX) return;
+
+   m_transformStore.setTransform(m_transformIdx, m_transl, getTranslation_abs(), m_rot, getRotation_abs(), m_scale);
+   m_transformStore.setZ(m_transformIdx, m_z);
+   m_transformStore.setParent(m_transformIdx, m_parent ? m_parent->m_transformIdx : TransformStore::NULL_INDEX);
+   m_transformStore.setBoundary(m_transformIdx, m_boundary.getPosition(), m_boundary.getSize());
 }
 
 //===========================================
@@ -535,6 +587,66 @@ void Entity::translate(float32_t x, float32_t y) {
       (*i)->onParentTransformation(oldRot, oldTransl);
 }
 
+//===========================================
+// Entity::translateMany
+//
+// Translates each entity by the corresponding delta. Each entity's onEvent()
+// still receives a translation event, but only a single
+// EEntityBatchTranslation is queued for the whole set.
+//===========================================
+void Entity::translateMany(const vector<pEntity_t>& entities, const vector<Vec2f>& deltas) {
+   if (entities.size() != deltas.size())
+      throw Exception("Error translating entities; Number of deltas does not match number of entities", __FILE__, __LINE__);
+
+   EEntityBatchTranslation* event = new EEntityBatchTranslation;
+   event->entries.reserve(entities.size());
+
+   for (uint_t i = 0; i < entities.size(); ++i)
+      entities[i]->translate_(deltas[i], event);
+
+   if (event->entries.empty()) {
+      delete event;
+      return;
+   }
+
+   m_eventManager.queueEvent(event);
+}
+
+//===========================================
+// Entity::translateMany
+//===========================================
+void Entity::translateMany(const vector<pEntity_t>& entities, const Vec2f& delta) {
+   translateMany(entities, vector<Vec2f>(entities.size(), delta));
+}
+
+//===========================================
+// Entity::translate_
+//
+// Used by translateMany. Changes are recorded in batch rather than queued.
+//===========================================
+void Entity::translate_(const Vec2f& delta, EEntityBatchTranslation* batch) {
+   Range bounds = m_boundary;
+
+   float32_t oldRot = getRotation_abs();
+   Vec2f oldTransl = getTranslation_abs();
+
+   m_transl = m_transl + delta;
+   recomputeBoundary();
+
+   if (!m_silent) {
+      Vec2f t = getTranslation_abs();
+
+      // This event isn't queued, so needn't be allocated from the event stack
+      EEntityTranslation event(shared_from_this(), m_transl - delta, oldTransl, m_transl, t);
+      onEvent(&event);
+
+      batch->entries.push_back(EEntityBatchTranslation::entry_t(shared_from_this(), bounds, m_boundary, oldTransl, t));
+   }
+
+   for (set<pEntity_t>::iterator i = m_children.begin(); i != m_children.end(); ++i)
+      (*i)->onParentTransformation(oldRot, oldTransl);
+}
+
 //===========================================
 // Entity::setTranslation_abs
 //===========================================
@@ -739,6 +851,13 @@ void Entity::setSilent(bool b) {
    m_silent = b;
 }
 
+//===========================================
+// Entity::setDormant
+//===========================================
+void Entity::setDormant(bool b) {
+   m_dormant = b;
+}
+
 //===========================================
 // Entity::clone
 //===========================================
@@ -794,7 +913,12 @@ Renderer::int_t Entity::getLineWidth() const {
 //===========================================
 // Entity::~Entity
 //===========================================
-Entity::~Entity() {}
+Entity::~Entity() {
+   EntityRegistry registry;
+   registry.remove(m_handle);
+
+   m_transformStore.release(m_transformIdx);
+}
 
 
 }
@@ -53,7 +53,10 @@ EntityAnimations::EntityAnimations(Entity* entity, pTexture_t texture)
      m_offset(0, 0),
      m_activeAnim(),
      m_model(Renderer::TRIANGLES),
-     m_renderer(Renderer::getInstance()) {}
+     m_renderer(Renderer::getInstance()) {
+
+   m_model.setGeometryId(internString("unitQuad"));
+}
 
 //===========================================
 // EntityAnimations::EntityAnimations
@@ -66,6 +69,8 @@ EntityAnimations::EntityAnimations(const EntityAnimations& copy, Entity* entity)
      m_model(Renderer::TRIANGLES),
      m_renderer(Renderer::getInstance()) {
 
+   m_model.setGeometryId(internString("unitQuad"));
+
    m_originalOffset = copy.m_originalOffset;
    m_offset = copy.m_offset;
    m_originalOnScreenSize = copy.m_originalOnScreenSize;
@@ -92,6 +97,8 @@ EntityAnimations::EntityAnimations(Entity* entity, const XmlNode data)
      m_model(Renderer::TRIANGLES),
      m_renderer(Renderer::getInstance()) {
 
+   m_model.setGeometryId(internString("unitQuad"));
+
    AssetManager assetManager;
 
    try {
@@ -210,6 +217,13 @@ void EntityAnimations::draw() const {
    m_renderer.draw(&m_model);
 }
 
+//===========================================
+// EntityAnimations::getModels
+//===========================================
+void EntityAnimations::getModels(std::vector<IModel*>& models) const {
+   models.push_back(&m_model);
+}
+
 //===========================================
 // EntityAnimations::playAnimation
 //
@@ -263,9 +277,12 @@ bool EntityAnimations::hasAnimation(long name) const {
 }
 
 //===========================================
-// EntityAnimations::updateModel
+// EntityAnimations::updateMatrix
+//
+// The model is a unit quad, so the matrix carries the on-screen size and
+// depth as well as the entity's position and rotation.
 //===========================================
-void EntityAnimations::updateModel() {
+void EntityAnimations::updateMatrix() {
    Vec2f pos = m_entity->getTranslation_abs() + m_offset;
 
    float32_t x = pos.x;
@@ -274,27 +291,58 @@ void EntityAnimations::updateModel() {
 
    float32_t angle = m_entity->getRotation_abs();
 
+   float32_t w = m_onScreenSize.x * m_entity->getScale().x;
+   float32_t h = m_onScreenSize.y * m_entity->getScale().y;
+
    matrix44f_c rotation;
    matrix44f_c translation;
+   matrix44f_c scale;
    matrix44f_c mv;
 
    float32_t rads = DEG_TO_RAD(angle);
    matrix_rotation_euler(rotation, 0.f, 0.f, rads, euler_order_xyz);
-   matrix_translation(translation, x, y, 0.f);
-   mv = translation * rotation;
+   matrix_translation(translation, x, y, z);
+   matrix_scale(scale, w, h, 1.f);
+   mv = translation * rotation * scale;
 
-   float32_t w = m_onScreenSize.x * m_entity->getScale().x;
-   float32_t h = m_onScreenSize.y * m_entity->getScale().y;
+   m_model.setMatrix(mv.data());
+}
+
+//===========================================
+// EntityAnimations::updateModel
+//
+// The vertex data never changes; animation frames only move the model's
+// texture rect.
+//===========================================
+void EntityAnimations::updateModel() {
+   if (m_model.getNumVertices() == 0) {
+      vvvtt_t verts[] = {
+         vvvtt_t(1.0, 0.0,  0.0,    1.0, 0.0),
+         vvvtt_t(1.0, 1.0,  0.0,    1.0, 1.0),
+         vvvtt_t(0.0, 0.0,  0.0,    0.0, 0.0),
+         vvvtt_t(1.0, 1.0,  0.0,    1.0, 1.0),
+         vvvtt_t(0.0, 1.0,  0.0,    0.0, 1.0),
+         vvvtt_t(0.0, 0.0,  0.0,    0.0, 0.0)
+      };
+
+      m_model.setVertices(0, verts, 6);
+      m_renderer.bufferModel(&m_model);
+   }
+
+   updateMatrix();
 
-   float32_t imgW = static_cast<float32_t>(m_texture->getWidth());
-   float32_t imgH = static_cast<float32_t>(m_texture->getHeight());
+   float32_t imgW = static_cast<float32_t>(m_texture->getAtlasWidth());
+   float32_t imgH = static_cast<float32_t>(m_texture->getAtlasHeight());
+
+   // In case the texture has been packed into an atlas
+   Range texSection = m_texture->mapSection(m_texSection);
 
    Vec2f halfPixel(0.5f / imgW, 0.5f / imgH);
 
-   float32_t tX1 = m_texSection.getPosition().x / imgW;
-   float32_t tX2 = (m_texSection.getPosition().x + m_texSection.getSize().x) / imgW;
-   float32_t tY1 = m_texSection.getPosition().y / imgH;
-   float32_t tY2 = (m_texSection.getPosition().y + m_texSection.getSize().y) / imgH;
+   float32_t tX1 = texSection.getPosition().x / imgW;
+   float32_t tX2 = (texSection.getPosition().x + texSection.getSize().x) / imgW;
+   float32_t tY1 = texSection.getPosition().y / imgH;
+   float32_t tY2 = (texSection.getPosition().y + texSection.getSize().y) / imgH;
 
    tX1 += halfPixel.x;
    tX2 -= halfPixel.x;
@@ -305,21 +353,9 @@ void EntityAnimations::updateModel() {
    tY1 = 1.f - tY1;
    tY2 = 1.f - tY2;
 
-   vvvtt_t verts[] = {
-      vvvtt_t(w,   0.0,  z,    tX2, tY1),
-      vvvtt_t(w,   h,    z,    tX2, tY2),
-      vvvtt_t(0.0, 0.0,  z,    tX1, tY1),
-      vvvtt_t(w,   h,    z,    tX2, tY2),
-      vvvtt_t(0.0, h,    z,    tX1, tY2),
-      vvvtt_t(0.0, 0.0,  z,    tX1, tY1)
-   };
-
-   m_model.setVertices(0, verts, 6);
-   m_model.setMatrix(mv.data());
+   m_model.setTextureRect(tX1, tY1, tX2 - tX1, tY2 - tY1);
    m_model.setColour(m_entity->getFillColour());
    m_model.setTextureHandle(m_texture->getHandle());
-
-   m_renderer.bufferModel(&m_model);
 }
 
 //===========================================
@@ -336,22 +372,7 @@ void EntityAnimations::onEvent(const EEvent* event) {
    else if (event->getType() == entityRotationStr
       || event->getType() == entityTranslationStr) {
 
-      Vec2f pos = m_entity->getTranslation_abs();
-
-      float32_t x = pos.x;
-      float32_t y = pos.y;
-
-      float32_t angle = m_entity->getRotation_abs();
-
-      matrix44f_c rotation;
-      matrix44f_c translation;
-      matrix44f_c mv;
-
-      float32_t rads = DEG_TO_RAD(angle);
-      matrix_rotation_euler(rotation, 0.f, 0.f, rads, euler_order_xyz);
-      matrix_translation(translation, x, y, 0.f);
-      mv = translation * rotation;
-      m_model.setMatrix(mv.data());
+      updateMatrix();
    }
 }
 
@@ -0,0 +1,119 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <boost/shared_ptr.hpp>
+#include <EntityRegistry.hpp>
+#include <EntityScheduler.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+EntityRegistry::slot_t* EntityRegistry::m_chunks[MAX_CHUNKS];
+uint_t EntityRegistry::m_freeHead = NULL_SLOT;
+uint_t EntityRegistry::m_numSlots = 0;
+uint_t EntityRegistry::m_numEntities = 0;
+mutex EntityRegistry::m_mutex;
+
+
+//===========================================
+// EntityRegistry::add
+//
+// Adding a slot may grow m_numSlots, which other threads read without a lock,
+// so this mustn't be called while EntityScheduler is running in parallel.
+//===========================================
+EntityHandle EntityRegistry::add(Entity* entity) {
+   if (EntityScheduler::inParallelSection())
+      throw Exception("Error registering entity; Entities can't be created during a parallel update or draw", __FILE__, __LINE__);
+
+   lock_guard<mutex> lock(m_mutex);
+
+   uint_t idx;
+
+   if (m_freeHead != NULL_SLOT) {
+      idx = m_freeHead;
+      m_freeHead = m_chunks[idx / CHUNK_SIZE][idx % CHUNK_SIZE].nextFree;
+   }
+   else {
+      if (m_numSlots % CHUNK_SIZE == 0) {
+         if (m_numSlots / CHUNK_SIZE == MAX_CHUNKS)
+            throw Exception("Error registering entity; Too many entities", __FILE__, __LINE__);
+
+         slot_t* chunk = new slot_t[CHUNK_SIZE];
+
+         for (uint_t i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i].entity.store(NULL);
+            chunk[i].generation.store(0);
+            chunk[i].nextFree = NULL_SLOT;
+         }
+
+         m_chunks[m_numSlots / CHUNK_SIZE] = chunk;
+      }
+
+      idx = m_numSlots++;
+   }
+
+   slot_t& slot = m_chunks[idx / CHUNK_SIZE][idx % CHUNK_SIZE];
+
+   uint_t generation = slot.generation.load() + 1;
+   if (generation == 0) ++generation; // Skip the null generation on wrap-around
+
+   slot.entity.store(entity, memory_order_release);
+   slot.generation.store(generation, memory_order_release);
+
+   ++m_numEntities;
+
+   return EntityHandle(idx, generation);
+}
+
+//===========================================
+// EntityRegistry::remove
+//
+// Bumping the generation first means a concurrent getEntity() sees either the
+// entity or NULL, never a slot that's half cleared.
+//===========================================
+void EntityRegistry::remove(const EntityHandle& handle) {
+   lock_guard<mutex> lock(m_mutex);
+
+   if (!isValid(handle)) return;
+
+   slot_t& slot = m_chunks[handle.index / CHUNK_SIZE][handle.index % CHUNK_SIZE];
+
+   uint_t generation = handle.generation + 1;
+   if (generation == 0) ++generation;
+
+   slot.generation.store(generation, memory_order_release);
+   slot.entity.store(NULL, memory_order_release);
+
+   slot.nextFree = m_freeHead;
+   m_freeHead = handle.index;
+
+   --m_numEntities;
+}
+
+//===========================================
+// EntityRegistry::getSharedPtr
+//
+// Returns a null pointer if the handle is stale or the entity isn't owned by
+// a shared_ptr.
+//===========================================
+pEntity_t EntityRegistry::getSharedPtr(const EntityHandle& handle) const {
+   Entity* entity = getEntity(handle);
+   if (!entity) return pEntity_t();
+
+   try {
+      return entity->getSharedPtr();
+   }
+   catch (boost::bad_weak_ptr&) {
+      return pEntity_t();
+   }
+}
+
+
+}
@@ -0,0 +1,467 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <EntityScheduler.hpp>
+#include <EntityPhysics.hpp>
+#include <renderer/Renderer.hpp>
+#include <globals.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+EventManager EntityScheduler::m_eventManager;
+
+// True while the calling thread is processing a level in parallel
+static THREAD_LOCAL bool parallelSection = false;
+
+
+//===========================================
+// EntityScheduler::EntityScheduler
+//===========================================
+EntityScheduler::EntityScheduler(uint_t numThreads)
+   : m_threshold(64),
+     m_batch(0),
+     m_busy(0),
+     m_running(true),
+     m_task(TASK_UPDATE),
+     m_entities(NULL),
+     m_level(NULL),
+     m_next(0),
+     m_firstChunk(0),
+     m_nextOrder(0) {
+
+   if (numThreads == 0) {
+      numThreads = thread::hardware_concurrency();
+
+      // The calling thread also does work
+      if (numThreads > 0) --numThreads;
+   }
+
+   size_t stackSize = gGetMemStack().getSize();
+
+   for (uint_t i = 0; i < numThreads; ++i)
+      m_stacks.push_back(unique_ptr<StackAllocator>(new StackAllocator(stackSize)));
+
+   for (uint_t i = 0; i < numThreads; ++i)
+      m_threads.push_back(new thread(&EntityScheduler::workerLoop, this, i));
+}
+
+//===========================================
+// EntityScheduler::workerLoop
+//===========================================
+void EntityScheduler::workerLoop(uint_t idx) {
+   gSetThreadMemStack(m_stacks[idx].get());
+
+   long batch = 0;
+
+   while (true) {
+      {
+         unique_lock<mutex> lock(m_mutex);
+
+         while (m_running && m_batch == batch)
+            m_cvStart.wait(lock);
+
+         if (!m_running) break;
+
+         batch = m_batch;
+      }
+
+      try {
+         processLevel();
+      }
+      catch (...) {
+         m_eventManager.redirectQueue(NULL);
+         Renderer::getInstance().redirectDraws(NULL);
+         parallelSection = false;
+
+         lock_guard<mutex> lock(m_mutex);
+         if (!m_exception) m_exception = current_exception();
+      }
+
+      {
+         lock_guard<mutex> lock(m_mutex);
+
+         if (--m_busy == 0)
+            m_cvDone.notify_one();
+      }
+   }
+
+   gSetThreadMemStack(NULL);
+}
+
+//===========================================
+// EntityScheduler::processLevel
+//
+// Called concurrently by every thread in the pool; entities are claimed in
+// chunks until the level is exhausted.
+//===========================================
+void EntityScheduler::processLevel() {
+   const vector<uint_t>& level = *m_level;
+   const vector<pEntity_t>& entities = *m_entities;
+
+   uint_t n = level.size();
+
+   Renderer& renderer = Renderer::getInstance();
+
+   parallelSection = true;
+
+   while (true) {
+      uint_t i = m_next.fetch_add(CHUNK_SIZE);
+      if (i >= n) break;
+
+      uint_t end = i + CHUNK_SIZE < n ? i + CHUNK_SIZE : n;
+
+      if (m_task == TASK_DRAW)
+         renderer.redirectDraws(m_chunkLists[m_firstChunk + i / CHUNK_SIZE]);
+
+      for (; i < end; ++i) {
+         uint_t e = level[i];
+
+         m_eventManager.redirectQueue(&m_eventBuffers[e]);
+
+         if (m_task == TASK_UPDATE)
+            entities[e]->update();
+         else
+            entities[e]->draw();
+      }
+   }
+
+   m_eventManager.redirectQueue(NULL);
+   renderer.redirectDraws(NULL);
+
+   parallelSection = false;
+}
+
+//===========================================
+// EntityScheduler::processSerial
+//
+// Updates the level's physics entities on the calling thread, in order. Only
+// updates are ever serialised.
+//===========================================
+void EntityScheduler::processSerial(const vector<uint_t>& level) {
+   const vector<pEntity_t>& entities = *m_entities;
+
+   for (uint_t i = 0; i < level.size(); ++i) {
+      uint_t e = level[i];
+
+      m_eventManager.redirectQueue(&m_eventBuffers[e]);
+      entities[e]->update();
+   }
+
+   m_eventManager.redirectQueue(NULL);
+}
+
+//===========================================
+// EntityScheduler::prepareDrawLists
+//
+// Assigns a list to each of the nChunks chunks, in order, taking lists from
+// the pool that the Renderer has finished with. Orders carry on from the
+// previous draw() unless every list has since been merged into a frame.
+//===========================================
+void EntityScheduler::prepareDrawLists(uint_t nChunks) {
+   vector<DrawList*> freeLists;
+
+   for (uint_t i = 0; i < m_drawListPool.size(); ++i) {
+      if (m_drawListPool[i]->getNumModels() == 0)
+         freeLists.push_back(m_drawListPool[i].get());
+   }
+
+   if (freeLists.size() == m_drawListPool.size())
+      m_nextOrder = 0;
+
+   m_chunkLists.clear();
+
+   for (uint_t i = 0; i < nChunks; ++i) {
+      DrawList* list = NULL;
+
+      if (i < freeLists.size()) {
+         list = freeLists[i];
+      }
+      else {
+         m_drawListPool.push_back(unique_ptr<DrawList>(new DrawList(0)));
+         list = m_drawListPool.back().get();
+      }
+
+      list->setOrder(m_nextOrder++);
+      m_chunkLists.push_back(list);
+   }
+}
+
+//===========================================
+// EntityScheduler::submitDrawLists
+//===========================================
+void EntityScheduler::submitDrawLists() {
+   Renderer& renderer = Renderer::getInstance();
+
+   for (uint_t i = 0; i < m_chunkLists.size(); ++i) {
+      if (m_chunkLists[i]->getNumModels() > 0)
+         renderer.submit(*m_chunkLists[i]);
+   }
+
+   m_chunkLists.clear();
+}
+
+//===========================================
+// EntityScheduler::clearDrawLists
+//
+// Discards a partially recorded draw() so its lists can be reused.
+//===========================================
+void EntityScheduler::clearDrawLists() {
+   for (uint_t i = 0; i < m_chunkLists.size(); ++i)
+      m_chunkLists[i]->clear();
+
+   m_chunkLists.clear();
+}
+
+//===========================================
+// EntityScheduler::inParallelSection
+//
+// Returns true if called from an update() or draw() that the scheduler is
+// running in parallel with others.
+//===========================================
+bool EntityScheduler::inParallelSection() {
+   return parallelSection;
+}
+
+//===========================================
+// EntityScheduler::hasPhysics
+//
+// True if the entity or any of its descendants has a physics body. Moving an
+// entity moves its children, so any of these may touch the physics world.
+//===========================================
+bool EntityScheduler::hasPhysics(const Entity* entity) {
+   if (dynamic_cast<const EntityPhysics*>(entity) != NULL) return true;
+
+   const set<pEntity_t>& children = entity->getChildren();
+
+   for (auto i = children.begin(); i != children.end(); ++i)
+      if (hasPhysics(i->get())) return true;
+
+   return false;
+}
+
+//===========================================
+// EntityScheduler::buildLevels
+//
+// Groups entity indices by hierarchy depth, preserving their relative order.
+// When updating, entities with physics go into the serial list for their
+// level.
+//===========================================
+void EntityScheduler::buildLevels(const vector<pEntity_t>& entities, task_t task) {
+   for (uint_t i = 0; i < m_levels.size(); ++i) {
+      m_levels[i].clear();
+      m_serialLevels[i].clear();
+   }
+
+   for (uint_t i = 0; i < entities.size(); ++i) {
+      uint_t depth = 0;
+      for (const Entity* p = entities[i]->getParent(); p != NULL; p = p->getParent())
+         ++depth;
+
+      if (depth >= m_levels.size()) {
+         m_levels.resize(depth + 1);
+         m_serialLevels.resize(depth + 1);
+      }
+
+      if (task == TASK_UPDATE && hasPhysics(entities[i].get()))
+         m_serialLevels[depth].push_back(i);
+      else
+         m_levels[depth].push_back(i);
+   }
+}
+
+//===========================================
+// EntityScheduler::runLevel
+//
+// Processes level l on every thread in the pool, including the calling thread.
+//===========================================
+void EntityScheduler::runLevel(uint_t l) {
+   m_level = &m_levels[l];
+   m_next = 0;
+
+   {
+      lock_guard<mutex> lock(m_mutex);
+
+      m_busy = m_threads.size();
+      ++m_batch;
+   }
+   m_cvStart.notify_all();
+
+   exception_ptr ex;
+
+   try {
+      processLevel();
+   }
+   catch (...) {
+      m_eventManager.redirectQueue(NULL);
+      Renderer::getInstance().redirectDraws(NULL);
+      parallelSection = false;
+
+      ex = current_exception();
+   }
+
+   unique_lock<mutex> lock(m_mutex);
+   while (m_busy > 0)
+      m_cvDone.wait(lock);
+
+   if (!ex && m_exception) ex = m_exception;
+   m_exception = exception_ptr();
+
+   if (ex) {
+      uint_t n = m_entities->size();
+
+      // Stop any remaining work on this level being picked up again
+      m_next = m_level->size();
+      m_entities = NULL;
+      m_level = NULL;
+
+      lock.unlock();
+
+      mergeEvents(n);
+      rethrow_exception(ex);
+   }
+}
+
+//===========================================
+// EntityScheduler::run
+//===========================================
+void EntityScheduler::run(const vector<pEntity_t>& entities, task_t task) {
+   if (m_threads.empty() || entities.size() < m_threshold) {
+      if (task == TASK_UPDATE) {
+         for (uint_t i = 0; i < entities.size(); ++i)
+            entities[i]->update();
+      }
+      else {
+         Renderer& renderer = Renderer::getInstance();
+
+         prepareDrawLists(1);
+         renderer.redirectDraws(m_chunkLists[0]);
+
+         try {
+            for (uint_t i = 0; i < entities.size(); ++i)
+               entities[i]->draw();
+         }
+         catch (...) {
+            renderer.redirectDraws(NULL);
+            clearDrawLists();
+            throw;
+         }
+
+         renderer.redirectDraws(NULL);
+         submitDrawLists();
+      }
+
+      return;
+   }
+
+   buildLevels(entities, task);
+
+   if (m_eventBuffers.size() < entities.size())
+      m_eventBuffers.resize(entities.size());
+
+   m_task = task;
+   m_entities = &entities;
+
+   if (task == TASK_DRAW) {
+      uint_t nChunks = 0;
+      for (uint_t l = 0; l < m_levels.size(); ++l)
+         nChunks += (m_levels[l].size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+      prepareDrawLists(nChunks);
+   }
+
+   m_firstChunk = 0;
+
+   for (uint_t l = 0; l < m_levels.size(); ++l) {
+      if (!m_levels[l].empty()) {
+         try {
+            runLevel(l);
+         }
+         catch (...) {
+            if (task == TASK_DRAW) clearDrawLists();
+            throw;
+         }
+      }
+
+      m_firstChunk += (m_levels[l].size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+      try {
+         processSerial(m_serialLevels[l]);
+      }
+      catch (...) {
+         m_eventManager.redirectQueue(NULL);
+
+         m_entities = NULL;
+         m_level = NULL;
+
+         mergeEvents(entities.size());
+         throw;
+      }
+   }
+
+   m_entities = NULL;
+   m_level = NULL;
+
+   if (task == TASK_DRAW)
+      submitDrawLists();
+
+   mergeEvents(entities.size());
+}
+
+//===========================================
+// EntityScheduler::mergeEvents
+//
+// Moves buffered events onto the main queue in entity order.
+//===========================================
+void EntityScheduler::mergeEvents(uint_t n) {
+   for (uint_t i = 0; i < n; ++i) {
+      vector<EEvent*>& buf = m_eventBuffers[i];
+
+      for (uint_t j = 0; j < buf.size(); ++j)
+         m_eventManager.queueEvent(buf[j]);
+
+      buf.clear();
+   }
+}
+
+//===========================================
+// EntityScheduler::update
+//===========================================
+void EntityScheduler::update(const vector<pEntity_t>& entities) {
+   run(entities, TASK_UPDATE);
+}
+
+//===========================================
+// EntityScheduler::draw
+//
+// The models are referenced rather than copied, so must remain unchanged until
+// the Renderer's next tick().
+//===========================================
+void EntityScheduler::draw(const vector<pEntity_t>& entities) {
+   run(entities, TASK_DRAW);
+}
+
+//===========================================
+// EntityScheduler::~EntityScheduler
+//===========================================
+EntityScheduler::~EntityScheduler() {
+   {
+      lock_guard<mutex> lock(m_mutex);
+      m_running = false;
+   }
+   m_cvStart.notify_all();
+
+   for (uint_t i = 0; i < m_threads.size(); ++i) {
+      m_threads[i]->join();
+      delete m_threads[i];
+   }
+}
+
+
+}
@@ -15,6 +15,7 @@ namespace Dodge {
 
 map<long, vector<Functor<void, TYPELIST_1(EEvent*)> > > EventManager::m_callbacks;
 queue<EEvent*> EventManager::m_eventQueue;
+THREAD_LOCAL vector<EEvent*>* EventManager::m_redirect = NULL;
 
 
 //===========================================
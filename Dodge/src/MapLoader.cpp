@@ -7,6 +7,7 @@
 #include <sstream>
 #include <globals.hpp>
 #include <MapLoader.hpp>
+#include <Entity.hpp>
 
 
 using namespace std;
@@ -64,6 +65,11 @@ void MapLoader::loadAssets(const XmlNode data, mapSegment_t* segment) {
          XML_ATTR_CHECK(attr, assetId);
          long id = attr.getLong();
 
+         bool isStatic = false;
+         for (attr = attr.nextAttribute(); !attr.isNull(); attr = attr.nextAttribute()) {
+            if (attr.name() == "static") isStatic = attr.getBool();
+         }
+
          // If asset is not already loaded
          if (!m_assetManager.getAssetPointer(id)) {
             boost::shared_ptr<Asset> asset = m_factoryFunc(node);
@@ -73,7 +79,10 @@ void MapLoader::loadAssets(const XmlNode data, mapSegment_t* segment) {
 
          m_refCountTable.incrRefCount(id);
 
-         if (segment) segment->assetIds.push_back(id);
+         if (segment) {
+            segment->assetIds.push_back(id);
+            if (isStatic) segment->staticAssetIds.push_back(id);
+         }
 
          node = node.nextSibling();
       }
@@ -93,6 +102,13 @@ size_t MapLoader::getMemoryUsage() const {
    for (auto i = m_assetManager.begin(); i != m_assetManager.end(); ++i)
       total += i->second->getSize();
 
+   for (uint_t i = 0; i < m_segments.size(); ++i) {
+      for (uint_t j = 0; j < m_segments[i].size(); ++j) {
+         if (m_segments[i][j].staticGeometry)
+            total += m_segments[i][j].staticGeometry->getSize();
+      }
+   }
+
    return total;
 }
 
@@ -264,6 +280,8 @@ void MapLoader::unloadSegments() {
       if (i != m_pendingUnload.end()) {
          mapSegment_t& seg = m_segments[i->x][i->y];
 
+         releaseStaticGeometry(seg);
+
          for (uint_t a = 0; a < seg.assetIds.size(); ++a) {
             long id = seg.assetIds[a];
 
@@ -301,11 +319,85 @@ void MapLoader::loadSegment(const Vec2i& indices) {
 
    if (!seg.loaded) {
       seg.assetIds.clear();
+      seg.staticAssetIds.clear();
       parseAssetsFile_r(seg.filePath, &seg);
+      bakeStaticGeometry(seg);
       seg.loaded = true;
    }
 }
 
+//===========================================
+// MapLoader::bakeStaticGeometry
+//
+// Merges the models of the segment's static entities and marks them as baked.
+//===========================================
+void MapLoader::bakeStaticGeometry(mapSegment_t& segment) {
+   if (segment.staticAssetIds.empty()) return;
+
+   boost::shared_ptr<StaticGeometry> geometry(new StaticGeometry);
+
+   // Only the assets baked by this segment are kept, so that releasing its
+   // geometry doesn't unmark models that another segment has baked.
+   vector<long> baked;
+
+   vector<IModel*> models;
+   for (uint_t a = 0; a < segment.staticAssetIds.size(); ++a) {
+      long id = segment.staticAssetIds[a];
+
+      Entity* entity = dynamic_cast<Entity*>(m_assetManager.getAssetPointer(id).get());
+      if (!entity) continue;
+
+      models.clear();
+      entity->getModels(models);
+
+      bool added = false;
+      for (uint_t m = 0; m < models.size(); ++m) {
+         if (geometry->add(models[m])) {
+            models[m]->setBaked(true);
+            added = true;
+         }
+      }
+
+      if (added) baked.push_back(id);
+   }
+
+   segment.staticAssetIds.swap(baked);
+
+   if (segment.staticAssetIds.empty()) return;
+
+   geometry->bake();
+
+   segment.staticGeometry = geometry;
+   m_currentMemUsage += geometry->getSize();
+}
+
+//===========================================
+// MapLoader::releaseStaticGeometry
+//
+// Frees the segment's static geometry. Its static entities are drawn
+// individually again if they outlive the segment.
+//===========================================
+void MapLoader::releaseStaticGeometry(mapSegment_t& segment) {
+   if (!segment.staticGeometry) return;
+
+   vector<IModel*> models;
+   for (uint_t a = 0; a < segment.staticAssetIds.size(); ++a) {
+      Entity* entity = dynamic_cast<Entity*>(m_assetManager.getAssetPointer(segment.staticAssetIds[a]).get());
+      if (!entity) continue;
+
+      models.clear();
+      entity->getModels(models);
+
+      for (uint_t m = 0; m < models.size(); ++m)
+         models[m]->setBaked(false);
+   }
+
+   m_currentMemUsage -= segment.staticGeometry->getSize();
+
+   segment.staticGeometry.reset();
+   segment.staticAssetIds.clear();
+}
+
 //===========================================
 // MapLoader::setPendingUnload
 //===========================================
@@ -415,11 +507,30 @@ Vec2i MapLoader::getSegment(const Vec2f& pos) const {
    return indices;
 }
 
+//===========================================
+// MapLoader::draw
+//
+// Draws the static geometry of all loaded segments.
+//===========================================
+void MapLoader::draw() const {
+   for (uint_t i = 0; i < m_segments.size(); ++i) {
+      for (uint_t j = 0; j < m_segments[i].size(); ++j) {
+         if (m_segments[i][j].staticGeometry)
+            m_segments[i][j].staticGeometry->draw();
+      }
+   }
+}
+
 //===========================================
 // MapLoader::freeAllAssets
 //===========================================
 void MapLoader::freeAllAssets() {
    if (m_init) {
+      for (uint_t i = 0; i < m_segments.size(); ++i) {
+         for (uint_t j = 0; j < m_segments[i].size(); ++j)
+            releaseStaticGeometry(m_segments[i][j]);
+      }
+
       m_assetManager.freeAllAssets();
       m_currentMemUsage = 0;
       m_pendingUnload.clear();
@@ -0,0 +1,76 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <PayloadRing.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// PayloadRing::PayloadRing
+//===========================================
+PayloadRing::PayloadRing(size_t size)
+   : m_data(NULL),
+     m_size(size),
+     m_head(0),
+     m_tail(0) {
+
+   if (size == 0 || size % ALIGNMENT != 0)
+      throw Exception("Error constructing PayloadRing; Size must be a non-zero multiple of 16", __FILE__, __LINE__);
+
+   m_data = new byte_t[size];
+}
+
+//===========================================
+// PayloadRing::alloc
+//
+// Called by the producer only. Returns NULL if there isn't currently enough
+// free space. Allocations never wrap around the end of the buffer; the
+// space at the end is skipped instead.
+//===========================================
+void* PayloadRing::alloc(size_t size, marker_t& end) {
+   size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+   if (size > m_size)
+      throw Exception("Error allocating from PayloadRing; Allocation larger than buffer", __FILE__, __LINE__);
+
+   size_t head = m_head.load(memory_order_relaxed);
+   size_t tail = m_tail.load(memory_order_acquire);
+   size_t pos = head % m_size;
+   size_t padding = pos + size > m_size ? m_size - pos : 0;
+
+   // If the ring is empty the skipped space holds nothing, so the allocation
+   // fits at the start of the buffer whatever its size
+   if (head != tail && head + padding + size - tail > m_size) return NULL;
+
+   end = head + padding + size;
+   m_head.store(end, memory_order_relaxed);
+
+   return m_data + (pos + padding) % m_size;
+}
+
+//===========================================
+// PayloadRing::release
+//
+// Called by the consumer only.
+//===========================================
+void PayloadRing::release(marker_t end) {
+   m_tail.store(end, memory_order_release);
+}
+
+//===========================================
+// PayloadRing::~PayloadRing
+//===========================================
+PayloadRing::~PayloadRing() {
+   delete[] m_data;
+}
+
+
+}
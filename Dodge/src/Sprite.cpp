@@ -171,6 +171,13 @@ void Sprite::draw() const {
    EntityAnimations::draw();
 }
 
+//===========================================
+// Sprite::getModels
+//===========================================
+void Sprite::getModels(vector<IModel*>& models) const {
+   EntityAnimations::getModels(models);
+}
+
 //===========================================
 // Sprite::update
 //===========================================
@@ -1,9 +1,15 @@
+#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
+#include <cml/cml.h>
+#pragma GCC diagnostic pop
 #include <TextEntity.hpp>
 #include <renderer/Renderer.hpp>
 #include <globals.hpp>
 #include <AssetManager.hpp>
 
 
+using namespace cml;
+
+
 namespace Dodge {
 
 
@@ -40,7 +46,9 @@ TextEntity::TextEntity(const XmlNode data)
 
       node = node.nextSibling();
       XML_NODE_CHECK(node, text);
-      setText(node.getString());
+      m_text = node.getString();
+
+      updateModel();
    }
    catch (XmlException& e) {
       e.prepend("Error parsing XML for instance of class TextEntity; ");
@@ -59,7 +67,8 @@ TextEntity::TextEntity(long type, const pFont_t font, const std::string& text, c
      m_size(size),
      m_model(Renderer::TRIANGLES) {
 
-   setText(text);
+   m_text = text;
+   updateModel();
 }
 
 //===========================================
@@ -73,7 +82,8 @@ TextEntity::TextEntity(long name, long type, const pFont_t font, const std::stri
      m_size(size),
      m_model(Renderer::TRIANGLES) {
 
-   setText(text);
+   m_text = text;
+   updateModel();
 }
 
 //===========================================
@@ -150,7 +160,9 @@ void TextEntity::assignData(const XmlNode data) {
       }
 
       XML_NODE_CHECK(node, text);
-      setText(node.getString());
+      m_text = node.getString();
+
+      updateModel();
    }
    catch (XmlException& e) {
       e.prepend("Error parsing XML for instance of class TextEntity; ");
@@ -165,6 +177,13 @@ void TextEntity::draw() const {
    m_renderer.draw(&m_model);
 }
 
+//===========================================
+// TextEntity::getModels
+//===========================================
+void TextEntity::getModels(std::vector<IModel*>& models) const {
+   models.push_back(&m_model);
+}
+
 //===========================================
 // TextEntity::update
 //===========================================
@@ -191,7 +210,7 @@ void TextEntity::onEvent(const EEvent* event) {
    if (event->getType() == entityRotationStr
       || event->getType() == entityTranslationStr) {
 
-      updateModel();
+      updateMatrix();
    }
 }
 
@@ -200,71 +219,117 @@ void TextEntity::onEvent(const EEvent* event) {
 //===========================================
 void TextEntity::setZ(float32_t z) {
    Entity::setZ(z);
-   m_model.setMatrixElement(14, z);
+   updateMatrix();
 }
 
 //===========================================
-// TextEntity::updateModel
+// TextEntity::tessellate
+//
+// Writes the quads of characters first to last - 1 into the model, in model
+// space.
 //===========================================
-void TextEntity::updateModel() const {
-   float32_t x = getTranslation_abs().x;
-   float32_t y = getTranslation_abs().y;
-   float32_t z = getZ();
-
-   float32_t texSectionX1 = m_font->getTextureSection().getPosition().x;
-   float32_t texSectionY1 = m_font->getTextureSection().getPosition().y;
-   float32_t texSectionX2 = texSectionX1 + m_font->getTextureSection().getSize().x;
-   float32_t texSectionY2 = texSectionY1 + m_font->getTextureSection().getSize().y;
-
-   float32_t texW = static_cast<float32_t>(m_font->getTexture()->getWidth());
-   float32_t texH = static_cast<float32_t>(m_font->getTexture()->getHeight());
+void TextEntity::tessellate(uint_t first, uint_t last) const {
+   if (last <= first) return;
 
-   float32_t pxChW = static_cast<float32_t>(m_font->getCharWidth());    // Char dimensions in pixels
-   float32_t pxChH = static_cast<float32_t>(m_font->getCharHeight());
-
-   int rowLen = static_cast<int>(static_cast<float32_t>(texSectionX2 - texSectionX1) / static_cast<float32_t>(pxChW));
+   float32_t w = m_size.x;
+   float32_t h = m_size.y;
 
    StackAllocator::marker_t marker = gGetMemStack().getMarker();
-   vvvtt_t* verts = reinterpret_cast<vvvtt_t*>(gGetMemStack().alloc(m_text.size() * 6 * sizeof(vvvtt_t)));
+   vvvtt_t* verts = reinterpret_cast<vvvtt_t*>(gGetMemStack().alloc((last - first) * 6 * sizeof(vvvtt_t)));
 
    int v = 0;
-   for (uint_t i = 0; i < m_text.length(); ++i) {
-      // Character world coords (pre-transformation)
-      float32_t chX = x + static_cast<float32_t>(i) * m_size.x;
-      float32_t chY = y;
-
-      float32_t srcX = texSectionX1 + pxChW * static_cast<float32_t>((m_text[i] - ' ') % rowLen);
-      float32_t srcY = texSectionY2 - pxChH * static_cast<float32_t>((m_text[i] - ' ') / rowLen + 1);
-
-      float32_t tY1 = srcY / texH;
-      float32_t tY2 = (srcY + pxChH) / texH;
-      tY1 = 1.f - tY1;
-      tY2 = 1.f - tY2;
-
-      verts[v] = vvvtt_t(chX + m_size.x, chY,            z,    (srcX + pxChW) / texW, tY1);    ++v;
-      verts[v] = vvvtt_t(chX + m_size.x, chY + m_size.y, z,    (srcX + pxChW) / texW, tY2);    ++v;
-      verts[v] = vvvtt_t(chX,            chY,            z,    srcX / texW,           tY1);    ++v;
-      verts[v] = vvvtt_t(chX + m_size.x, chY + m_size.y, z,    (srcX + pxChW) / texW, tY2);    ++v;
-      verts[v] = vvvtt_t(chX,            chY + m_size.y, z,    srcX / texW,           tY2);    ++v;
-      verts[v] = vvvtt_t(chX,            chY,            z,    srcX / texW,           tY1);    ++v;
+   for (uint_t i = first; i < last; ++i) {
+      Font::glyph_t glyph = m_font->getGlyph(m_text[i]);
+
+      float32_t chX = static_cast<float32_t>(i) * w;
+
+      verts[v] = vvvtt_t(chX + w,   0.f,  0.f,    glyph.u2, glyph.v1);    ++v;
+      verts[v] = vvvtt_t(chX + w,   h,    0.f,    glyph.u2, glyph.v2);    ++v;
+      verts[v] = vvvtt_t(chX,       0.f,  0.f,    glyph.u1, glyph.v1);    ++v;
+      verts[v] = vvvtt_t(chX + w,   h,    0.f,    glyph.u2, glyph.v2);    ++v;
+      verts[v] = vvvtt_t(chX,       h,    0.f,    glyph.u1, glyph.v2);    ++v;
+      verts[v] = vvvtt_t(chX,       0.f,  0.f,    glyph.u1, glyph.v1);    ++v;
    }
 
+   m_model.setVertices(6 * first, verts, 6 * (last - first));
+
+   gGetMemStack().freeToMarker(marker);
+}
+
+//===========================================
+// TextEntity::updateModel
+//
+// Rebuilds the whole model.
+//===========================================
+void TextEntity::updateModel() const {
    m_model.eraseVertices();
-   m_model.setVertices(0, verts, 6 * m_text.size());
+   tessellate(0, m_text.length());
+
    m_model.setColour(getFillColour());
    m_model.setLineWidth(0);
    m_model.setTextureHandle(m_font->getTexture()->getHandle());
 
+   updateMatrix();
+
    m_renderer.bufferModel(&m_model);
+}
 
-   gGetMemStack().freeToMarker(marker);
+//===========================================
+// TextEntity::updateMatrix
+//===========================================
+void TextEntity::updateMatrix() const {
+   Vec2f pos = getTranslation_abs();
+
+   matrix44f_c rotation;
+   matrix44f_c translation;
+   matrix44f_c mv;
+
+   float32_t rads = DEG_TO_RAD(getRotation_abs());
+   matrix_rotation_euler(rotation, 0.f, 0.f, rads, euler_order_xyz);
+   matrix_translation(translation, pos.x, pos.y, getZ());
+   mv = translation * rotation;
+
+   m_model.setMatrix(mv.data());
 }
 
 //===========================================
 // TextEntity::setText
+//
+// Only the characters that differ from the current text are re-tessellated.
+// If the text gets shorter, the quads past its end are dropped.
+//
+// Text that changes after it's created (a score counter, for example) is
+// assumed to change often, so its model is made dynamic rather than being
+// buffered again each time.
 //===========================================
 void TextEntity::setText(const std::string& text) {
+   if (text == m_text) return;
+
+   if (!m_model.isDynamic()) {
+      m_renderer.freeBufferedModel(&m_model);
+      m_model.setDynamic(true);
+   }
+
+   uint_t first = 0;
+   while (first < m_text.length() && first < text.length() && text[first] == m_text[first]) ++first;
+
+   uint_t last = text.length();
+   if (text.length() == m_text.length()) {
+      while (last > first && text[last - 1] == m_text[last - 1]) --last;
+   }
+
+   if (text.length() < m_text.length())
+      m_model.truncateVertices(6 * text.length());
+
    m_text = text;
+   tessellate(first, last);
+}
+
+//===========================================
+// TextEntity::setTextSize
+//===========================================
+void TextEntity::setTextSize(float32_t x, float32_t y) {
+   m_size = Vec2f(x, y);
    updateModel();
 }
 
@@ -0,0 +1,84 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <TransformStore.hpp>
+#include <EntityScheduler.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+const TransformStore::index_t TransformStore::NULL_INDEX;
+
+bool TransformStore::m_enabled = false;
+
+TransformStore::arrays_t* TransformStore::m_arrays = NULL;
+mutex TransformStore::m_freeListMutex;
+
+
+//===========================================
+// TransformStore::allocate
+//
+// Returns NULL_INDEX if the store is disabled. Allocating may grow the arrays,
+// which other threads write to without a lock, so this mustn't be called
+// while EntityScheduler is running in parallel.
+//===========================================
+TransformStore::index_t TransformStore::allocate(Entity* entity) {
+   if (!m_enabled) return NULL_INDEX;
+
+   if (EntityScheduler::inParallelSection())
+      throw Exception("Error allocating transform slot; Entities can't be created during a parallel update or draw", __FILE__, __LINE__);
+
+   lock_guard<mutex> lock(m_freeListMutex);
+
+   if (!m_arrays) m_arrays = new arrays_t;
+
+   index_t idx;
+
+   if (!m_arrays->freeList.empty()) {
+      idx = m_arrays->freeList.back();
+      m_arrays->freeList.pop_back();
+   }
+   else {
+      idx = static_cast<index_t>(m_arrays->entity.size());
+
+      m_arrays->entity.push_back(NULL);
+      m_arrays->transl.push_back(Vec2f(0.f, 0.f));
+      m_arrays->transl_abs.push_back(Vec2f(0.f, 0.f));
+      m_arrays->rot.push_back(0.f);
+      m_arrays->rot_abs.push_back(0.f);
+      m_arrays->scale.push_back(Vec2f(1.f, 1.f));
+      m_arrays->z.push_back(0.f);
+      m_arrays->parent.push_back(NULL_INDEX);
+      m_arrays->boundPos.push_back(Vec2f(0.f, 0.f));
+      m_arrays->boundSize.push_back(Vec2f(0.f, 0.f));
+   }
+
+   m_arrays->entity[idx] = entity;
+   m_arrays->parent[idx] = NULL_INDEX;
+
+   return idx;
+}
+
+//===========================================
+// TransformStore::release
+//===========================================
+void TransformStore::release(index_t idx) {
+   if (idx == NULL_INDEX) return;
+
+   lock_guard<mutex> lock(m_freeListMutex);
+
+   m_arrays->entity[idx] = NULL;
+   m_arrays->parent[idx] = NULL_INDEX;
+
+   m_arrays->freeList.push_back(idx);
+}
+
+
+}
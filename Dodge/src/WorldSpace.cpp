@@ -31,6 +31,35 @@ void WorldSpace::entityMovedHandler(EEvent* e) {
    }
 }
 
+//===========================================
+// WorldSpace::entityBatchMovedHandler
+//===========================================
+void WorldSpace::entityBatchMovedHandler(EEvent* e) {
+   assert(m_init);
+
+   EEntityBatchTranslation* event = static_cast<EEntityBatchTranslation*>(e);
+
+   std::vector<pEntity_t> entities;
+   std::vector<Range> oldBoxes;
+   std::vector<Range> newBoxes;
+
+   entities.reserve(event->entries.size());
+   oldBoxes.reserve(event->entries.size());
+   newBoxes.reserve(event->entries.size());
+
+   for (uint_t i = 0; i < event->entries.size(); ++i) {
+      const EEntityBatchTranslation::entry_t& entry = event->entries[i];
+
+      if (m_tracking.find(entry.entity) != m_tracking.end()) {
+         entities.push_back(entry.entity);
+         oldBoxes.push_back(entry.oldBoundingBox);
+         newBoxes.push_back(entry.newBoundingBox);
+      }
+   }
+
+   m_container->moveMany(entities, oldBoxes, newBoxes);
+}
+
 //===========================================
 // WorldSpace::init
 //===========================================
@@ -40,6 +69,9 @@ void WorldSpace::init(std::unique_ptr<SpatialContainer<pEntity_t> > container) {
    Functor<void, TYPELIST_1(EEvent*)> fEntMovedHandler(this, &WorldSpace::entityMovedHandler);
    m_eventManager.registerCallback(internString("entityBoundingBox"), fEntMovedHandler);
 
+   Functor<void, TYPELIST_1(EEvent*)> fEntBatchMovedHandler(this, &WorldSpace::entityBatchMovedHandler);
+   m_eventManager.registerCallback(internString("entityBatchTranslation"), fEntBatchMovedHandler);
+
    m_init = true;
 }
 
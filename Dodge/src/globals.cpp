@@ -20,6 +20,8 @@ float32_t targetFrameRate;
 projectSettings_t settings;
 int gFlag = 0; // TODO
 
+static THREAD_LOCAL StackAllocator* threadMemStack = NULL;
+
 
 //===========================================
 // gInitialise
@@ -47,14 +49,29 @@ float32_t gGetTargetFrameRate() {
 
 //===========================================
 // gGetMemStack
+//
+// Returns the calling thread's stack if one has been set, otherwise the
+// global stack, which only the main thread should use.
 //===========================================
 StackAllocator& gGetMemStack() {
+   if (threadMemStack) return *threadMemStack;
+
    if (!init)
       throw Exception("Error retrieving memory stack; Globals not initialised", __FILE__, __LINE__);
 
    return *memStack;
 }
 
+//===========================================
+// gSetThreadMemStack
+//
+// Overrides the stack returned by gGetMemStack() for the calling thread only.
+// Pass NULL to restore the global stack.
+//===========================================
+void gSetThreadMemStack(StackAllocator* stack) {
+   threadMemStack = stack;
+}
+
 //===========================================
 // gGetWorkingDir
 //===========================================
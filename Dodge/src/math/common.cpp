@@ -2,10 +2,44 @@
 #include <math/Vec2f.hpp>
 
 
+using namespace std;
+
+
 namespace Dodge {
 namespace Math {
 
 
+//===========================================
+// cross
+//
+// Twice the signed area of triangle abc; positive if abc is anti-clockwise.
+//===========================================
+static float32_t cross(const Vec2f& a, const Vec2f& b, const Vec2f& c) {
+   return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+//===========================================
+// isEar
+//
+// Returns true if no other remaining vertex lies inside or on the
+// anti-clockwise triangle abc.
+//===========================================
+static bool isEar(const vector<Vec2f>& poly, const vector<int>& idx, const Vec2f& a, const Vec2f& b,
+   const Vec2f& c) {
+
+   for (uint_t i = 0; i < idx.size(); ++i) {
+      const Vec2f& p = poly[idx[i]];
+
+      if (p == a || p == b || p == c) continue;
+
+      if (cross(a, b, p) >= 0.f && cross(b, c, p) >= 0.f && cross(c, a, p) >= 0.f)
+         return false;
+   }
+
+   return true;
+}
+
+
 //===========================================
 // Math::lineIntersect
 //
@@ -38,6 +72,76 @@ bool lineIntersect(const Vec2f& l1p1, const Vec2f& l1p2, const Vec2f& l2p1, cons
    return true;
 }
 
+//===========================================
+// Math::triangulate
+//
+// Triangulates a simple polygon, convex or concave and of either winding, by
+// ear clipping. Writes the indices of each triangle's vertices to triangles in
+// anti-clockwise order. No zero-area triangles are produced; a collinear
+// vertex is dropped if it would be the tip of one. If the polygon isn't
+// simple, the vertices that remain once no more ears can be found are fanned.
+//===========================================
+void triangulate(const vector<Vec2f>& poly, vector<int>& triangles) {
+   triangles.clear();
+
+   int n = poly.size();
+   if (n < 3) return;
+
+   float32_t area = 0.f;
+   for (int i = 0; i < n; ++i)
+      area += poly[i].x * poly[(i + 1) % n].y - poly[(i + 1) % n].x * poly[i].y;
+
+   // Indices of the remaining vertices, in anti-clockwise order
+   vector<int> idx(n);
+   for (int i = 0; i < n; ++i)
+      idx[i] = area >= 0.f ? i : n - 1 - i;
+
+   uint_t i = 0;
+   uint_t tried = 0;
+
+   while (idx.size() > 3) {
+      uint_t m = idx.size();
+
+      int ia = idx[(i + m - 1) % m];
+      int ib = idx[i];
+      int ic = idx[(i + 1) % m];
+
+      float32_t c = cross(poly[ia], poly[ib], poly[ic]);
+
+      if (c == 0.f || (c > 0.f && isEar(poly, idx, poly[ia], poly[ib], poly[ic]))) {
+         if (c != 0.f) {
+            triangles.push_back(ia);
+            triangles.push_back(ib);
+            triangles.push_back(ic);
+         }
+
+         idx.erase(idx.begin() + i);
+         if (i >= idx.size()) i = 0;
+
+         tried = 0;
+      }
+      else {
+         i = (i + 1) % m;
+
+         if (++tried == m) {
+            for (uint_t j = 1; j + 1 < m; ++j) {
+               triangles.push_back(idx[0]);
+               triangles.push_back(idx[j]);
+               triangles.push_back(idx[j + 1]);
+            }
+
+            return;
+         }
+      }
+   }
+
+   if (cross(poly[idx[0]], poly[idx[1]], poly[idx[2]]) != 0.f) {
+      triangles.push_back(idx[0]);
+      triangles.push_back(idx[1]);
+      triangles.push_back(idx[2]);
+   }
+}
+
 
 }
 }
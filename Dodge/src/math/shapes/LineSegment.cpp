@@ -169,6 +169,13 @@ void LineSegment::draw() const {
    m_renderer.draw(&m_model);
 }
 
+//===========================================
+// LineSegment::getModels
+//===========================================
+void LineSegment::getModels(std::vector<IModel*>& models) const {
+   models.push_back(&m_model);
+}
+
 //===========================================
 // LineSegment::getMinimum
 //===========================================
@@ -7,6 +7,7 @@
 #include <cstring>
 #include <definitions.hpp>
 #include <math/shapes/Polygon.hpp>
+#include <math/common.hpp>
 #include <StringId.hpp>
 #include <globals.hpp>
 
@@ -18,15 +19,21 @@ using namespace std;
 namespace Dodge {
 
 
+//===========================================
+// Polygon::renderState_t::renderState_t
+//===========================================
+Polygon::renderState_t::renderState_t()
+   : outlineModel(Renderer::LINES),
+     interiorModel(Renderer::TRIANGLES),
+     dirty(true),
+     trianglesDirty(true) {}
+
 //===========================================
 // Polygon::Polygon
 //===========================================
 Polygon::Polygon()
    : Asset(internString("Polygon")),
-     m_nVerts(0),
-     m_outlineModel(Renderer::LINES),
-     m_interiorModel(Renderer::TRIANGLES),
-     m_renderer(Renderer::getInstance()) {
+     m_nVerts(0) {
 
 //   m_verts.resize(Polygon::MAX_VERTS);
 }
@@ -35,10 +42,7 @@ Polygon::Polygon()
 // Polygon::Polygon
 //===========================================
 Polygon::Polygon(const XmlNode data)
-   : Asset(internString("Polygon")),
-     m_outlineModel(Renderer::LINES),
-     m_interiorModel(Renderer::TRIANGLES),
-     m_renderer(Renderer::getInstance()) {
+   : Asset(internString("Polygon")) {
 
    try {
       XML_NODE_CHECK(data, Polygon);
@@ -60,7 +64,6 @@ Polygon::Polygon(const XmlNode data)
    }
 
    restructure();
-   updateModels();
 }
 
 //===========================================
@@ -70,10 +73,7 @@ Polygon::Polygon(const XmlNode data)
 //===========================================
 Polygon::Polygon(const Polygon& poly)
    : Asset(internString("Polygon")),
-     Shape(poly),
-     m_outlineModel(Renderer::LINES),
-     m_interiorModel(Renderer::TRIANGLES),
-     m_renderer(Renderer::getInstance()) {
+     Shape(poly) {
 
    deepCopy(poly);
 }
@@ -94,8 +94,20 @@ void Polygon::deepCopy(const Polygon& copy) {
 
    restructure();
 
-   m_outlineModel = copy.m_outlineModel;
-   m_interiorModel = copy.m_interiorModel;
+   // Only the render settings are copied; the models are rebuilt when needed
+   if (copy.m_render) {
+      m_render.reset(new renderState_t);
+
+      m_render->outlineModel.setColour(copy.m_render->outlineModel.getColour());
+      m_render->outlineModel.setLineWidth(copy.m_render->outlineModel.getLineWidth());
+      m_render->interiorModel.setColour(copy.m_render->interiorModel.getColour());
+
+      m_render->triangles = copy.m_render->triangles;
+      m_render->trianglesDirty = copy.m_render->trianglesDirty;
+   }
+   else {
+      m_render.reset();
+   }
 }
 
 //===========================================
@@ -107,11 +119,17 @@ size_t Polygon::getSize() const { // TODO: Keep up to date
    for (uint_t i = 0; i < m_children.size(); ++i)
       childrenSz += m_children[i].getSize();
 
+   size_t renderSz = 0;
+   if (m_render) {
+      renderSz = sizeof(renderState_t)
+         - sizeof(PlainNonTexturedAlphaModel)
+         - sizeof(PlainNonTexturedAlphaModel)
+         + m_render->outlineModel.getTotalSize()
+         + m_render->interiorModel.getTotalSize();
+   }
+
    return sizeof(Polygon)
-      - sizeof(PlainNonTexturedAlphaModel)
-      - sizeof(PlainNonTexturedAlphaModel)
-      + m_outlineModel.getTotalSize()
-      + m_interiorModel.getTotalSize()
+      + renderSz
       + m_verts.size() * sizeof(boost::shared_ptr<Vec2f>)
       + childrenSz;
 }
@@ -221,7 +239,7 @@ void Polygon::addVertex(const Vec2f& vert) {
    ++m_nVerts;
 
    restructure();
-   updateModels();
+   invalidateTriangulation();
 }
 
 //===========================================
@@ -237,7 +255,7 @@ void Polygon::removeVertex(int idx) {
    --m_nVerts;
 
    restructure();
-   updateModels();
+   invalidateTriangulation();
 }
 
 //===========================================
@@ -255,63 +273,103 @@ void Polygon::insertVertex(int idx, const Vec2f& vert) {
    *m_verts[idx] = vert;
 
    restructure();
-   updateModels();
+   invalidateTriangulation();
 }
 
 //===========================================
 // Polygon::setFillColour
 //===========================================
 void Polygon::setFillColour(const Colour& colour) const {
-   m_interiorModel.setColour(colour);
+   getRenderState().interiorModel.setColour(colour);
 }
 
 //===========================================
 // Polygon::setLineColour
 //===========================================
 void Polygon::setLineColour(const Colour& colour) const {
-   m_outlineModel.setColour(colour);
+   getRenderState().outlineModel.setColour(colour);
 }
 
 //===========================================
 // Polygon::setLineWidth
 //===========================================
 void Polygon::setLineWidth(int lineWidth) const {
-   m_outlineModel.setLineWidth(lineWidth);
+   getRenderState().outlineModel.setLineWidth(lineWidth);
 }
 
 //===========================================
 // Polygon::setRenderTransform
 //===========================================
 void Polygon::setRenderTransform(float32_t x, float32_t y, float32_t z) const {
-   m_outlineModel.setMatrixElement(12, x);
-   m_outlineModel.setMatrixElement(13, y);
-   m_outlineModel.setMatrixElement(14, z + 1);
+   renderState_t& state = getRenderState();
+
+   state.outlineModel.setMatrixElement(12, x);
+   state.outlineModel.setMatrixElement(13, y);
+   state.outlineModel.setMatrixElement(14, z + 1);
 
-   m_interiorModel.setMatrixElement(12, x);
-   m_interiorModel.setMatrixElement(13, y);
-   m_interiorModel.setMatrixElement(14, z);
+   state.interiorModel.setMatrixElement(12, x);
+   state.interiorModel.setMatrixElement(13, y);
+   state.interiorModel.setMatrixElement(14, z);
 }
 
 //===========================================
 // Polygon::draw
 //===========================================
 void Polygon::draw() const {
-   m_renderer.draw(&m_interiorModel);
-   m_renderer.draw(&m_outlineModel);
+   updateModels();
+
+   Renderer& renderer = Renderer::getInstance();
+
+   renderer.draw(&m_render->interiorModel);
+   renderer.draw(&m_render->outlineModel);
+}
+
+//===========================================
+// Polygon::getModels
+//===========================================
+void Polygon::getModels(std::vector<IModel*>& models) const {
+   updateModels();
+
+   models.push_back(&m_render->interiorModel);
+   models.push_back(&m_render->outlineModel);
+}
+
+//===========================================
+// Polygon::getRenderState
+//===========================================
+Polygon::renderState_t& Polygon::getRenderState() const {
+   if (!m_render) m_render.reset(new renderState_t);
+
+   return *m_render;
 }
 
 //===========================================
 // Polygon::updateModels
+//
+// Rebuilds the models if the vertices have changed since they were last
+// built.
 //===========================================
 void Polygon::updateModels() const {
-   updateOutlineModel();
-   updateInteriorModel();
+   renderState_t& state = getRenderState();
+
+   if (state.dirty) {
+      updateOutlineModel();
+      updateInteriorModel();
+
+      state.dirty = false;
+   }
 }
 
 //===========================================
 // Polygon::updateOutlineModel
+//
+// Called from draw(), which EntityScheduler may run on several threads at
+// once. Each of its workers has its own gGetMemStack().
 //===========================================
 void Polygon::updateOutlineModel() const {
+   if (m_render->outlineModel.getNumVertices() > static_cast<uint_t>(m_nVerts * 2))
+      m_render->outlineModel.eraseVertices();
+
    StackAllocator& stack = gGetMemStack();
    StackAllocator::marker_t marker = stack.getMarker();
 
@@ -326,40 +384,48 @@ void Polygon::updateOutlineModel() const {
       ++i;
    }
 
-   m_outlineModel.setVertices(0, verts, m_nVerts * 2);
+   m_render->outlineModel.setVertices(0, verts, m_nVerts * 2);
 
    stack.freeToMarker(marker);
 }
 
 //===========================================
 // Polygon::updateInteriorModel
+//
+// Triangulates the polygon if its vertices have changed, then copies the
+// vertices of the cached triangles into the model.
 //===========================================
-void Polygon::updateInteriorModel() const { // TODO: for each convex child
-   if (m_nVerts < 3) return;
+void Polygon::updateInteriorModel() const {
+   renderState_t& state = *m_render;
 
-   // Construct triangle fan
+   if (state.trianglesDirty) {
+      std::vector<Vec2f> poly(m_nVerts);
+      for (int v = 0; v < m_nVerts; ++v)
+         poly[v] = getVertex(v);
 
+      Math::triangulate(poly, state.triangles);
+      state.trianglesDirty = false;
+   }
 
-   StackAllocator& stack = gGetMemStack();
-   StackAllocator::marker_t marker = stack.getMarker();
+   uint_t n = state.triangles.size();
 
-   // The number of vertices in a triangle fan is 3n-6,
-   // where n is the number of vertices in the polygon.
-   vvv_t* verts = reinterpret_cast<vvv_t*>(stack.alloc((3 * m_nVerts - 6) * sizeof(vvv_t)));
+   // setVertices() never shrinks the model
+   if (state.interiorModel.getNumVertices() > n)
+      state.interiorModel.eraseVertices();
 
-   int i = 0;
-   for (int v = 1; v < m_nVerts - 1; ++v) {
-      verts[i] = vvv_t(getVertex(0).x, getVertex(0).y, 0.f);
-      ++i;
+   if (n == 0) return;
 
-      verts[i] = vvv_t(getVertex(v).x, getVertex(v).y, 0.f);
-      ++i;
+   StackAllocator& stack = gGetMemStack();
+   StackAllocator::marker_t marker = stack.getMarker();
 
-      verts[i] = vvv_t(getVertex(v + 1).x, getVertex(v + 1).y, 0.f);
-      ++i;
+   vvv_t* verts = reinterpret_cast<vvv_t*>(stack.alloc(n * sizeof(vvv_t)));
+
+   for (uint_t i = 0; i < n; ++i) {
+      const Vec2f& vert = getVertex(state.triangles[i]);
+      verts[i] = vvv_t(vert.x, vert.y, 0.f);
    }
 
-   m_interiorModel.setVertices(0, verts, 3 * m_nVerts - 6);
+   state.interiorModel.setVertices(0, verts, n);
 
    stack.freeToMarker(marker);
 }
@@ -403,7 +469,7 @@ void Polygon::rotate(float32_t deg, const Vec2f& p) {
    for (int i = 0; i < m_nVerts; ++i)
       m_verts[i]->rotate(p, deg);
 
-   updateModels();
+   invalidateModels();
 }
 
 //===========================================
@@ -417,7 +483,7 @@ void Polygon::scale(const Vec2f& sv) {
       m_verts[i]->y = m_verts[i]->y * sv.y;
    }
 
-   updateModels();
+   invalidateModels();
 }
 
 //===========================================
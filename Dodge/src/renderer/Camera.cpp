@@ -10,14 +10,14 @@ namespace Dodge {
 void Camera::setProjection(float32_t width, float32_t height) {
    Vec2f s = getTranslation();
 
-   m_mutex.lock();
+   beginWrite();
 
-   matrix_orthographic_RH(m_matrix, width, height, 0.01f, 100.f, cml::z_clip_neg_one);
+   matrix_orthographic_RH(m_state.matrix, width, height, 0.01f, 100.f, cml::z_clip_neg_one);
 
-   m_viewSize.x = width;
-   m_viewSize.y = height;
+   m_state.viewSize.x = width;
+   m_state.viewSize.y = height;
 
-   m_mutex.unlock();
+   endWrite();
 
    setTranslation(s.x, s.y);
 }
@@ -26,27 +26,26 @@ void Camera::setProjection(float32_t width, float32_t height) {
 // Camera::setTranslation
 //===========================================
 void Camera::setTranslation(float32_t x, float32_t y) {
-   m_mutex.lock();
+   beginWrite();
 
-   m_matrix.data()[12] = -(x * 2.f) / (m_viewSize.x / m_viewSize.y) - 1.f;
-   m_matrix.data()[13] = -(y * 2.f) - 1.f;
+   m_state.matrix.data()[12] = -(x * 2.f) / (m_state.viewSize.x / m_state.viewSize.y) - 1.f;
+   m_state.matrix.data()[13] = -(y * 2.f) - 1.f;
 
    // Move the camera back slightly (any small negative number will do as
    // we're using an orthographic projection).
-   m_matrix.data()[14] = -0.001f;
+   m_state.matrix.data()[14] = -0.001f;
 
-   m_mutex.unlock();
+   endWrite();
 }
 
 //===========================================
 // Camera::getTranslation
 //===========================================
 Vec2f Camera::getTranslation() const {
-   m_mutex.lock();
-   Vec2f tmp(-0.5f * (m_viewSize.x / m_viewSize.y) * (m_matrix.data()[12] + 1.f), -0.5f * (m_matrix.data()[13] + 1.f));
-   m_mutex.unlock();
+   state_t state = getState();
 
-   return tmp;
+   return Vec2f(-0.5f * (state.viewSize.x / state.viewSize.y) * (state.matrix.data()[12] + 1.f),
+      -0.5f * (state.matrix.data()[13] + 1.f));
 }
 
 
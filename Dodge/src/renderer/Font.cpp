@@ -2,6 +2,7 @@
 #include <StringId.hpp>
 #include <xml/xml.hpp>
 #include <AssetManager.hpp>
+#include <Exception.hpp>
 
 
 namespace Dodge {
@@ -44,6 +45,8 @@ Font::Font(const XmlNode data)
       e.prepend("Error parsing XML for instance of class Font; ");
       throw;
    }
+
+   buildGlyphs();
 }
 
 //===========================================
@@ -56,6 +59,7 @@ Font::Font(const Font& copy)
    m_texSection = copy.m_texSection;
    m_charW = copy.m_charW;
    m_charH = copy.m_charH;
+   m_glyphs = copy.m_glyphs;
 }
 
 //===========================================
@@ -65,7 +69,75 @@ Font::Font(pTexture_t texture, float32_t texX, float32_t texY, float32_t texW, f
    : Asset(internString("Font")),
      m_texture(texture),
      m_texSection(texX, texY, texW, texH),
-     m_charW(charW), m_charH(charH) {}
+     m_charW(charW), m_charH(charH) {
+
+   buildGlyphs();
+}
+
+//===========================================
+// Font::buildGlyphs
+//===========================================
+void Font::buildGlyphs() {
+   float32_t texSectionX1 = m_texSection.getPosition().x;
+   float32_t texSectionY2 = m_texSection.getPosition().y + m_texSection.getSize().y;
+
+   float32_t texW = static_cast<float32_t>(m_texture->getWidth());
+   float32_t texH = static_cast<float32_t>(m_texture->getHeight());
+
+   float32_t pxChW = static_cast<float32_t>(m_charW);    // Char dimensions in pixels
+   float32_t pxChH = static_cast<float32_t>(m_charH);
+
+   int rowLen = static_cast<int>(m_texSection.getSize().x / pxChW);
+   int nRows = static_cast<int>(m_texSection.getSize().y / pxChH);
+
+   if (rowLen <= 0 || nRows <= 0)
+      throw Exception("Error computing glyph texture coordinates; Texture section is smaller than a character", __FILE__, __LINE__);
+
+   m_glyphs.resize(rowLen * nRows);
+
+   for (int i = 0; i < rowLen * nRows; ++i) {
+      float32_t srcX = texSectionX1 + pxChW * static_cast<float32_t>(i % rowLen);
+      float32_t srcY = texSectionY2 - pxChH * static_cast<float32_t>(i / rowLen + 1);
+
+      glyph_t& glyph = m_glyphs[i];
+      glyph.u1 = srcX / texW;
+      glyph.v1 = 1.f - srcY / texH;
+      glyph.u2 = (srcX + pxChW) / texW;
+      glyph.v2 = 1.f - (srcY + pxChH) / texH;
+   }
+}
+
+//===========================================
+// Font::getGlyph
+//
+// Characters not in the font are drawn as spaces.
+//===========================================
+Font::glyph_t Font::getGlyph(char c) const {
+   int i = static_cast<int>(c) - ' ';
+   if (i < 0 || i >= static_cast<int>(m_glyphs.size())) i = 0;
+
+   glyph_t glyph = m_glyphs[i];
+
+   if (m_texture->isInAtlas()) {
+      float32_t texW = static_cast<float32_t>(m_texture->getWidth());
+      float32_t texH = static_cast<float32_t>(m_texture->getHeight());
+      float32_t atlasW = static_cast<float32_t>(m_texture->getAtlasWidth());
+      float32_t atlasH = static_cast<float32_t>(m_texture->getAtlasHeight());
+
+      // Position of the texture's bottom-left corner within the atlas
+      Vec2f offset = m_texture->mapSection(Range(0.f, 0.f, texW, texH)).getPosition();
+
+      float32_t du = offset.x / atlasW;
+      float32_t dv = 1.f - (offset.y + texH) / atlasH;
+
+      glyph.u1 = du + glyph.u1 * texW / atlasW;
+      glyph.u2 = du + glyph.u2 * texW / atlasW;
+      glyph.v1 = dv + glyph.v1 * texH / atlasH;
+      glyph.v2 = dv + glyph.v2 * texH / atlasH;
+   }
+
+   return glyph;
+}
 
 //===========================================
 // Font::clone
@@ -78,7 +150,7 @@ Asset* Font::clone() const {
 // Font::getSize
 //===========================================
 size_t Font::getSize() const {
-   return sizeof(Font);
+   return sizeof(Font) + m_glyphs.capacity() * sizeof(glyph_t);
 }
 
 
@@ -9,7 +9,7 @@
 namespace Dodge {
 
 
-long IModel::nextId = 0;
+std::atomic<long> IModel::nextId(0);
 
 
 }
@@ -0,0 +1,81 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <renderer/ModelCache.hpp>
+#include <renderer/Model.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// freeSnapshot
+//
+// The copy's vertices live in the same block of memory as the copy itself, so
+// the model's destructor mustn't be called.
+//===========================================
+static void freeSnapshot(const IModel* model) {
+   delete[] reinterpret_cast<const byte_t*>(model);
+}
+
+//===========================================
+// ModelCache::ModelCache
+//===========================================
+ModelCache::ModelCache()
+   : m_frame(0) {}
+
+//===========================================
+// ModelCache::makeSnapshot
+//===========================================
+pModelSnapshot_t ModelCache::makeSnapshot(const IModel* model) {
+   byte_t* ptr = new byte_t[model->getTotalSize()];
+   model->copyTo(ptr);
+
+   return pModelSnapshot_t(reinterpret_cast<const IModel*>(ptr), freeSnapshot);
+}
+
+//===========================================
+// ModelCache::getSnapshot
+//
+// Returns a copy of the model, reusing the previous copy if the model hasn't
+// changed since it was made. Sets copied to true if a new copy was made.
+//===========================================
+pModelSnapshot_t ModelCache::getSnapshot(const IModel* model, bool& copied) {
+   entry_t& entry = m_entries[model->m_id];
+
+   copied = !entry.snapshot || entry.version != model->getVersion();
+
+   if (copied) {
+      entry.snapshot = makeSnapshot(model);
+      entry.version = model->getVersion();
+   }
+
+   entry.frame = m_frame;
+
+   return entry.snapshot;
+}
+
+//===========================================
+// ModelCache::endFrame
+//
+// Discards copies of models that weren't drawn this frame. Copies still in
+// use by a scene graph are kept alive by it.
+//===========================================
+void ModelCache::endFrame() {
+   for (auto i = m_entries.begin(); i != m_entries.end();) {
+      if (i->second.frame != m_frame)
+         m_entries.erase(i++);
+      else
+         ++i;
+   }
+
+   ++m_frame;
+}
+
+
+}
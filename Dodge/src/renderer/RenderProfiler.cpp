@@ -0,0 +1,197 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <renderer/RenderProfiler.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// RenderProfiler::frameStats_t::frameStats_t
+//===========================================
+RenderProfiler::frameStats_t::frameStats_t()
+   : frame(0),
+     duplicate(false) {
+
+   for (int i = 0; i < NUM_FIELDS; ++i)
+      values[i] = 0.0;
+}
+
+//===========================================
+// RenderProfiler::RenderProfiler
+//===========================================
+RenderProfiler::RenderProfiler(uint_t capacity)
+   : m_frames(capacity),
+     m_next(0),
+     m_count(0),
+     m_enabled(false) {
+
+   if (capacity == 0)
+      throw Exception("Error constructing RenderProfiler; Capacity must be non-zero", __FILE__, __LINE__);
+}
+
+//===========================================
+// RenderProfiler::record
+//===========================================
+void RenderProfiler::record(const frameStats_t& stats) {
+   lock_guard<mutex> lock(m_mutex);
+
+   m_frames[m_next] = stats;
+   m_next = (m_next + 1) % m_frames.size();
+
+   if (m_count < m_frames.size()) ++m_count;
+}
+
+//===========================================
+// RenderProfiler::clear
+//===========================================
+void RenderProfiler::clear() {
+   lock_guard<mutex> lock(m_mutex);
+
+   m_next = 0;
+   m_count = 0;
+}
+
+//===========================================
+// RenderProfiler::getNumFrames
+//===========================================
+uint_t RenderProfiler::getNumFrames() const {
+   lock_guard<mutex> lock(m_mutex);
+   return m_count;
+}
+
+//===========================================
+// RenderProfiler::getFrame
+//
+// Frame 0 is the oldest frame in the buffer.
+//===========================================
+RenderProfiler::frameStats_t RenderProfiler::getFrame(uint_t i) const {
+   lock_guard<mutex> lock(m_mutex);
+
+   if (i >= m_count)
+      throw Exception("Error retrieving frame statistics; Index out of range", __FILE__, __LINE__);
+
+   return m_frames[(m_next + m_frames.size() - m_count + i) % m_frames.size()];
+}
+
+//===========================================
+// isMainThreadField
+//===========================================
+static inline bool isMainThreadField(RenderProfiler::field_t field) {
+   return field < RenderProfiler::MSG_TIME;
+}
+
+//===========================================
+// RenderProfiler::getPercentile
+//
+// Returns the value of field below which p percent of the buffered frames
+// lie, using the nearest-rank method. Duplicate frames are skipped for main
+// thread fields, as their zeros would skew the result. Returns 0 if there are
+// no frames.
+//===========================================
+double RenderProfiler::getPercentile(field_t field, float32_t p) const {
+   if (field < 0 || field >= NUM_FIELDS || p < 0.f || p > 100.f)
+      throw Exception("Error computing percentile; Bad arguments", __FILE__, __LINE__);
+
+   vector<double> values;
+
+   {
+      lock_guard<mutex> lock(m_mutex);
+
+      bool skipDuplicates = isMainThreadField(field);
+
+      values.reserve(m_count);
+      for (uint_t i = 0; i < m_count; ++i) {
+         if (skipDuplicates && m_frames[i].duplicate) continue;
+         values.push_back(m_frames[i].values[field]);
+      }
+   }
+
+   if (values.empty()) return 0.0;
+
+   size_t rank = static_cast<size_t>(ceil(p / 100.0 * values.size()));
+   size_t idx = rank > 0 ? rank - 1 : 0;
+
+   nth_element(values.begin(), values.begin() + idx, values.end());
+
+   return values[idx];
+}
+
+//===========================================
+// RenderProfiler::getFieldName
+//
+// Used as the column headings when exporting to CSV.
+//===========================================
+const char* RenderProfiler::getFieldName(field_t field) {
+   switch (field) {
+      case INSERT_TIME:       return "insert_ms";
+      case SCRATCH_BYTES:     return "scratch_bytes";
+      case SORT_TIME:         return "sort_ms";
+      case TICK_WAIT_TIME:    return "tick_wait_ms";
+      case MSG_TIME:          return "msg_ms";
+      case SUBMIT_TIME:       return "submit_ms";
+      case SWAP_TIME:         return "swap_ms";
+      case FRAME_TIME:        return "frame_ms";
+      case DRAW_CALLS:        return "draw_calls";
+      case PROGRAM_SWITCHES:  return "program_switches";
+      case TEXTURE_SWITCHES:  return "texture_switches";
+      case VERTICES:          return "vertices";
+      default:                return "unknown";
+   }
+}
+
+//===========================================
+// RenderProfiler::exportCsv
+//
+// Writes one row per buffered frame, oldest first.
+//===========================================
+void RenderProfiler::exportCsv(ostream& out) const {
+   out << "frame,duplicate";
+   for (int f = 0; f < NUM_FIELDS; ++f)
+      out << "," << getFieldName(static_cast<field_t>(f));
+
+   out << "\n";
+
+   lock_guard<mutex> lock(m_mutex);
+
+   for (uint_t i = 0; i < m_count; ++i) {
+      const frameStats_t& stats = m_frames[(m_next + m_frames.size() - m_count + i) % m_frames.size()];
+
+      out << stats.frame << "," << (stats.duplicate ? 1 : 0);
+      for (int f = 0; f < NUM_FIELDS; ++f)
+         out << "," << stats.values[f];
+
+      out << "\n";
+   }
+}
+
+//===========================================
+// RenderProfiler::exportCsv
+//===========================================
+void RenderProfiler::exportCsv(const string& file) const {
+   ofstream fout(file.data());
+
+   if (!fout.good()) {
+      fout.close();
+
+      stringstream msg;
+      msg << "Error writing to file " << file;
+      throw Exception(msg.str(), __FILE__, __LINE__);
+   }
+
+   exportCsv(fout);
+}
+
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <renderer/RenderRules.hpp>
+#include <renderer/Renderer.hpp>
+#include <renderer/Model.hpp>
+#include <renderer/Camera.hpp>
+#include <StringId.hpp>
+
+
+namespace Dodge {
+
+
+//===========================================
+// RenderRules::getCullRect
+//
+// Writes the left, bottom, right and top edges of the camera's view, expanded
+// by margin, to rect.
+//===========================================
+void RenderRules::getCullRect(const Camera& camera, float32_t margin, float32_t* rect) {
+   Vec2f pos = camera.getTranslation();
+   Vec2f size = camera.getViewSize();
+
+   rect[0] = pos.x - margin;
+   rect[1] = pos.y - margin;
+   rect[2] = pos.x + size.x + margin;
+   rect[3] = pos.y + size.y + margin;
+}
+
+//===========================================
+// RenderRules::isVisible
+//
+// Tests the model's world-space bounding rectangle against a rectangle given
+// by getCullRect().
+//===========================================
+bool RenderRules::isVisible(const IModel* model, const float32_t* cullRect) {
+   Renderer::vertexElement_t b[4];
+   if (!model->getLocalBounds(b)) return false;
+
+   const Renderer::matrixElement_t* m = model->m_matrix;
+
+   float32_t x1 = 0.f, y1 = 0.f, x2 = 0.f, y2 = 0.f;
+
+   // Transform each corner of the bounding rectangle
+   for (int i = 0; i < 4; ++i) {
+      Renderer::vertexElement_t x = b[(i & 1) ? 2 : 0];
+      Renderer::vertexElement_t y = b[(i & 2) ? 3 : 1];
+
+      float32_t tx = m[0] * x + m[4] * y + m[12];
+      float32_t ty = m[1] * x + m[5] * y + m[13];
+
+      if (i == 0 || tx < x1) x1 = tx;
+      if (i == 0 || ty < y1) y1 = ty;
+      if (i == 0 || tx > x2) x2 = tx;
+      if (i == 0 || ty > y2) y2 = ty;
+   }
+
+   return x2 >= cullRect[0] && x1 <= cullRect[2]
+      && y2 >= cullRect[1] && y1 <= cullRect[3];
+}
+
+//===========================================
+// RenderRules::canBatch
+//
+// True if b can be drawn in the same draw call as a. Only triangle lists are
+// merged; lines and strips can't be concatenated without changing their
+// appearance.
+//===========================================
+bool RenderRules::canBatch(const IModel* a, const IModel* b) {
+   static long vvvtt = internString("vvvtt");
+   static long vvvttcccc = internString("vvvttcccc");
+
+   long layoutA = a->getVertexLayout();
+   long layoutB = b->getVertexLayout();
+
+   bool texturedA = layoutA == vvvtt || layoutA == vvvttcccc;
+   bool texturedB = layoutB == vvvtt || layoutB == vvvttcccc;
+
+   return a->getPrimitiveType() == Renderer::TRIANGLES
+      && b->getPrimitiveType() == Renderer::TRIANGLES
+      && a->getRenderMode() == b->getRenderMode()
+      && a->getTextureHandle() == b->getTextureHandle()
+      && texturedA == texturedB;
+}
+
+
+}
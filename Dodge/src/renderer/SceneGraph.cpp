@@ -3,6 +3,7 @@
  * Date: 2012
  */
 
+#include <cstring>
 #include <renderer/SceneGraph.hpp>
 
 
@@ -25,7 +26,80 @@ void SceneGraph::insert(const IModel* model) {
 
    model->copyTo(ptr);
 
-   m_container.insert(entry_t(key_t(subKey_t(ptr->getDepth(), ptr->getRenderMode()), ptr->getTextureHandle()), ptr));
+   entry_t entry = { computeKey(ptr), ptr };
+   m_container.push_back(entry);
+}
+
+//===========================================
+// SceneGraph::insert
+//===========================================
+void SceneGraph::insert(const pModelSnapshot_t& snapshot) {
+   entry_t entry = { computeKey(snapshot.get()), snapshot.get() };
+   m_container.push_back(entry);
+
+   m_snapshots.push_back(snapshot);
+}
+
+//===========================================
+// SceneGraph::computeKey
+//===========================================
+SceneGraph::key_t SceneGraph::computeKey(const IModel* model) {
+   float32_t depth = model->getDepth();
+
+   uint32_t bits;
+   memcpy(&bits, &depth, sizeof(bits));
+
+   // Map the float's bit pattern to an unsigned integer with the same ordering
+   bits = (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+
+   key_t mode = static_cast<key_t>(model->getRenderMode()) & 0xff;
+   key_t tex = static_cast<key_t>(model->getTextureHandle()) & 0xffffff;
+
+   return (static_cast<key_t>(bits) << 32) | (mode << 24) | tex;
+}
+
+//===========================================
+// SceneGraph::sort
+//
+// LSD radix sort on the entries' keys, one byte at a time. The sort is stable,
+// so models with equal keys stay in the order they were inserted. Passes over
+// bytes that are the same for every entry are skipped.
+//===========================================
+void SceneGraph::sort() {
+   size_t n = m_container.size();
+   if (n < 2) return;
+
+   m_sortBuffer.resize(n);
+
+   entry_t* src = &m_container[0];
+   entry_t* dest = &m_sortBuffer[0];
+
+   for (uint_t shift = 0; shift < 64; shift += 8) {
+      size_t count[256];
+      memset(count, 0, sizeof(count));
+
+      for (size_t i = 0; i < n; ++i)
+         ++count[(src[i].key >> shift) & 0xff];
+
+      if (count[(src[0].key >> shift) & 0xff] == n) continue;
+
+      size_t offset = 0;
+      for (uint_t b = 0; b < 256; ++b) {
+         size_t c = count[b];
+         count[b] = offset;
+         offset += c;
+      }
+
+      for (size_t i = 0; i < n; ++i)
+         dest[count[(src[i].key >> shift) & 0xff]++] = src[i];
+
+      entry_t* tmp = src;
+      src = dest;
+      dest = tmp;
+   }
+
+   if (src != &m_container[0])
+      m_container.swap(m_sortBuffer);
 }
 
 //===========================================
@@ -34,6 +108,7 @@ void SceneGraph::insert(const IModel* model) {
 void SceneGraph::clear() {
    m_container.clear();
    m_scratchSpace.clear();
+   m_snapshots.clear();
 }
 
 //===========================================
@@ -0,0 +1,247 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <renderer/StaticGeometry.hpp>
+#include <StringId.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// readVertices
+//===========================================
+template <class T>
+static void readVertices(const IModel* model, vector<T>& verts) {
+   verts.resize(model->getNumVertices());
+   model->getVertices(verts.data(), 0, verts.size());
+}
+
+//===========================================
+// transform
+//
+// Multiplies (x, y, z, 1) by the column-major matrix m.
+//===========================================
+static void transform(const Renderer::matrixElement_t* m, Renderer::vertexElement_t& x,
+   Renderer::vertexElement_t& y, Renderer::vertexElement_t& z) {
+
+   Renderer::vertexElement_t x_ = m[0] * x + m[4] * y + m[8] * z + m[12];
+   Renderer::vertexElement_t y_ = m[1] * x + m[5] * y + m[9] * z + m[13];
+   Renderer::vertexElement_t z_ = m[2] * x + m[6] * y + m[10] * z + m[14];
+
+   x = x_;
+   y = y_;
+   z = z_;
+}
+
+//===========================================
+// StaticGeometry::key_t::operator<
+//===========================================
+bool StaticGeometry::key_t::operator<(const key_t& rhs) const {
+   if (mode != rhs.mode) return mode < rhs.mode;
+   if (primitiveType != rhs.primitiveType) return primitiveType < rhs.primitiveType;
+   if (texture != rhs.texture) return texture < rhs.texture;
+   if (lineWidth != rhs.lineWidth) return lineWidth < rhs.lineWidth;
+
+   return depth < rhs.depth;
+}
+
+//===========================================
+// StaticGeometry::StaticGeometry
+//===========================================
+StaticGeometry::StaticGeometry()
+   : m_baked(false),
+     m_renderer(Renderer::getInstance()) {}
+
+//===========================================
+// StaticGeometry::add
+//
+// Returns false if the model can't be merged, in which case it should still
+// be drawn individually.
+//===========================================
+bool StaticGeometry::add(const IModel* model) {
+   static long vvvStr = internString("vvv");
+   static long vvvccccStr = internString("vvvcccc");
+   static long vvvttStr = internString("vvvtt");
+   static long vvvttccccStr = internString("vvvttcccc");
+
+   if (m_baked)
+      throw Exception("Error adding model to static geometry; Geometry has already been baked", __FILE__, __LINE__);
+
+   if (model->isBaked() || model->getNumVertices() == 0) return false;
+
+   Renderer::primitive_t primitiveType = model->getPrimitiveType();
+   if (primitiveType != Renderer::TRIANGLES && primitiveType != Renderer::LINES) return false;
+
+   long layout = model->getVertexLayout();
+   if (layout != vvvStr && layout != vvvccccStr && layout != vvvttStr && layout != vvvttccccStr) return false;
+
+   Renderer::matrixElement_t m[16];
+   model->getMatrix(m);
+
+   Colour col = model->getColour();
+   const Renderer::texCoordElement_t* rect = model->getTextureRect();
+
+   key_t key;
+   key.primitiveType = primitiveType;
+   key.texture = 0;
+   key.lineWidth = primitiveType == Renderer::LINES ? model->getLineWidth() : 0;
+
+   if (layout == vvvStr || layout == vvvccccStr) {
+      vector<vvvcccc_t> verts;
+
+      if (layout == vvvStr) {
+         vector<vvv_t> src;
+         readVertices(model, src);
+
+         verts.resize(src.size());
+         for (uint_t i = 0; i < src.size(); ++i)
+            verts[i] = vvvcccc_t(src[i].v1, src[i].v2, src[i].v3, col.r, col.g, col.b, col.a);
+      }
+      else {
+         readVertices(model, verts);
+      }
+
+      for (uint_t i = 0; i < verts.size(); ++i)
+         transform(m, verts[i].v1, verts[i].v2, verts[i].v3);
+
+      key.mode = Renderer::NONTEXTURED_ALPHA;
+      key.depth = verts[0].v3;
+
+      vector<vvvcccc_t>& dest = m_groups[key].nonTextured;
+      dest.insert(dest.end(), verts.begin(), verts.end());
+   }
+   else {
+      vector<vvvttcccc_t> verts;
+
+      if (layout == vvvttStr) {
+         vector<vvvtt_t> src;
+         readVertices(model, src);
+
+         verts.resize(src.size());
+         for (uint_t i = 0; i < src.size(); ++i) {
+            verts[i] = vvvttcccc_t(src[i].v1, src[i].v2, src[i].v3, src[i].t1, src[i].t2,
+               col.r, col.g, col.b, col.a);
+         }
+      }
+      else {
+         readVertices(model, verts);
+      }
+
+      for (uint_t i = 0; i < verts.size(); ++i) {
+         transform(m, verts[i].v1, verts[i].v2, verts[i].v3);
+
+         verts[i].t1 = rect[0] + verts[i].t1 * rect[2];
+         verts[i].t2 = rect[1] + verts[i].t2 * rect[3];
+      }
+
+      key.mode = Renderer::TEXTURED_ALPHA;
+      key.texture = model->getTextureHandle();
+      key.depth = verts[0].v3;
+
+      vector<vvvttcccc_t>& dest = m_groups[key].textured;
+      dest.insert(dest.end(), verts.begin(), verts.end());
+   }
+
+   return true;
+}
+
+//===========================================
+// StaticGeometry::bakeModel
+//===========================================
+void StaticGeometry::bakeModel(const key_t& key, const group_t& grp, uint_t start, uint_t num) {
+   IModel* model;
+
+   if (key.mode == Renderer::TEXTURED_ALPHA) {
+      ColouredTexturedAlphaModel* m = new ColouredTexturedAlphaModel(key.primitiveType);
+      m->setVertices(0, grp.textured.data() + start, num);
+
+      model = m;
+   }
+   else {
+      ColouredNonTexturedAlphaModel* m = new ColouredNonTexturedAlphaModel(key.primitiveType);
+      m->setVertices(0, grp.nonTextured.data() + start, num);
+
+      model = m;
+   }
+
+   model->setTextureHandle(key.texture);
+   model->setLineWidth(key.lineWidth);
+
+   m_models.push_back(boost::shared_ptr<IModel>(model));
+   m_renderer.bufferModel(model);
+}
+
+//===========================================
+// StaticGeometry::bake
+//
+// Builds and buffers the merged models, splitting groups larger than
+// MAX_VERTICES. Models can't be added afterwards.
+//===========================================
+void StaticGeometry::bake() {
+   if (m_baked) return;
+
+   for (auto i = m_groups.begin(); i != m_groups.end(); ++i) {
+      const key_t& key = i->first;
+      const group_t& grp = i->second;
+
+      uint_t n = key.mode == Renderer::TEXTURED_ALPHA ? grp.textured.size() : grp.nonTextured.size();
+
+      for (uint_t start = 0; start < n; start += MAX_VERTICES)
+         bakeModel(key, grp, start, n - start < MAX_VERTICES ? n - start : MAX_VERTICES);
+   }
+
+   m_groups.clear();
+   m_baked = true;
+}
+
+//===========================================
+// StaticGeometry::draw
+//===========================================
+void StaticGeometry::draw() const {
+   for (uint_t i = 0; i < m_models.size(); ++i)
+      m_renderer.draw(m_models[i].get());
+}
+
+//===========================================
+// StaticGeometry::release
+//
+// Frees the merged models, after which the geometry is empty and can be
+// added to again.
+//===========================================
+void StaticGeometry::release() {
+   for (uint_t i = 0; i < m_models.size(); ++i)
+      m_renderer.freeBufferedModel(m_models[i].get());
+
+   m_models.clear();
+   m_groups.clear();
+   m_baked = false;
+}
+
+//===========================================
+// StaticGeometry::getSize
+//===========================================
+size_t StaticGeometry::getSize() const {
+   size_t total = sizeof(StaticGeometry);
+
+   for (uint_t i = 0; i < m_models.size(); ++i)
+      total += m_models[i]->getTotalSize();
+
+   return total;
+}
+
+//===========================================
+// StaticGeometry::~StaticGeometry
+//===========================================
+StaticGeometry::~StaticGeometry() {
+   release();
+}
+
+
+}
@@ -0,0 +1,228 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <climits>
+#include <cstring>
+#include <renderer/TextureAtlas.hpp>
+#include <Exception.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// TextureAtlas::TextureAtlas
+//===========================================
+TextureAtlas::TextureAtlas(Renderer::int_t width, Renderer::int_t height, Renderer::int_t padding)
+   : m_width(width),
+     m_height(height),
+     m_padding(padding),
+     m_handle(0),
+     m_renderer(Renderer::getInstance()) {
+
+   if (width <= 0 || height <= 0 || padding < 0)
+      throw Exception("Error constructing TextureAtlas; Bad dimensions", __FILE__, __LINE__);
+
+   skylineNode_t node = { 0, 0, width };
+   m_skyline.push_back(node);
+}
+
+//===========================================
+// TextureAtlas::fits
+//
+// If a rectangle of size (w, h) fits with its left edge at the start of
+// skyline node idx, returns true and sets y to the lowest position it can
+// be placed.
+//===========================================
+bool TextureAtlas::fits(uint_t idx, Renderer::int_t w, Renderer::int_t h, Renderer::int_t& y) const {
+   Renderer::int_t x = m_skyline[idx].x;
+   if (x + w > m_width) return false;
+
+   Renderer::int_t widthLeft = w;
+   y = m_skyline[idx].y;
+
+   while (widthLeft > 0) {
+      if (m_skyline[idx].y > y) y = m_skyline[idx].y;
+      if (y + h > m_height) return false;
+
+      widthLeft -= m_skyline[idx].w;
+      ++idx;
+   }
+
+   return true;
+}
+
+//===========================================
+// TextureAtlas::findPosition
+//
+// Chooses the position that leaves the lowest skyline, preferring narrower
+// nodes on a tie.
+//===========================================
+bool TextureAtlas::findPosition(Renderer::int_t w, Renderer::int_t h, uint_t& idx, Renderer::int_t& x, Renderer::int_t& y) const {
+   Renderer::int_t bestTop = INT_MAX;
+   Renderer::int_t bestWidth = INT_MAX;
+   bool found = false;
+
+   for (uint_t i = 0; i < m_skyline.size(); ++i) {
+      Renderer::int_t top;
+
+      if (fits(i, w, h, top)) {
+         if (top + h < bestTop || (top + h == bestTop && m_skyline[i].w < bestWidth)) {
+            bestTop = top + h;
+            bestWidth = m_skyline[i].w;
+
+            idx = i;
+            x = m_skyline[i].x;
+            y = top;
+            found = true;
+         }
+      }
+   }
+
+   return found;
+}
+
+//===========================================
+// TextureAtlas::addSkylineLevel
+//===========================================
+void TextureAtlas::addSkylineLevel(uint_t idx, Renderer::int_t x, Renderer::int_t y, Renderer::int_t w, Renderer::int_t h) {
+   skylineNode_t node = { x, y + h, w };
+   m_skyline.insert(m_skyline.begin() + idx, node);
+
+   // Trim or remove the nodes now covered by the new one
+   for (uint_t i = idx + 1; i < m_skyline.size(); ++i) {
+      skylineNode_t& prev = m_skyline[i - 1];
+      skylineNode_t& curr = m_skyline[i];
+
+      if (curr.x >= prev.x + prev.w) break;
+
+      Renderer::int_t shrink = prev.x + prev.w - curr.x;
+
+      curr.x += shrink;
+      curr.w -= shrink;
+
+      if (curr.w > 0) break;
+
+      m_skyline.erase(m_skyline.begin() + i);
+      --i;
+   }
+
+   // Merge neighbouring nodes at the same height
+   for (uint_t i = 0; i + 1 < m_skyline.size(); ++i) {
+      if (m_skyline[i].y == m_skyline[i + 1].y) {
+         m_skyline[i].w += m_skyline[i + 1].w;
+         m_skyline.erase(m_skyline.begin() + i + 1);
+         --i;
+      }
+   }
+}
+
+//===========================================
+// TextureAtlas::addTexture
+//
+// Returns false if the texture doesn't fit or is already in an atlas.
+//===========================================
+bool TextureAtlas::addTexture(pTexture_t texture) {
+   if (m_handle != 0)
+      throw Exception("Error adding texture to atlas; Atlas has already been built", __FILE__, __LINE__);
+
+   if (texture->isInAtlas()) return false;
+
+   for (uint_t i = 0; i < m_entries.size(); ++i)
+      if (m_entries[i].texture.lock() == texture) return true;
+
+   Renderer::int_t w = texture->getWidth() + 2 * m_padding;
+   Renderer::int_t h = texture->getHeight() + 2 * m_padding;
+
+   uint_t idx;
+   Renderer::int_t x, y;
+   if (!findPosition(w, h, idx, x, y)) return false;
+
+   addSkylineLevel(idx, x, y, w, h);
+
+   entry_t entry;
+   entry.texture = texture;
+   entry.x = x + m_padding;
+   entry.y = y + m_padding;
+
+   m_entries.push_back(entry);
+
+   return true;
+}
+
+//===========================================
+// TextureAtlas::addFont
+//===========================================
+bool TextureAtlas::addFont(pFont_t font) {
+   return addTexture(font->getTexture());
+}
+
+//===========================================
+// TextureAtlas::build
+//
+// Copies the textures' pixel data into the atlas and uploads it. Padding is
+// filled by extending each texture's edge pixels outwards, so filtering at
+// the borders doesn't pick up neighbouring textures.
+//===========================================
+void TextureAtlas::build() {
+   if (m_handle != 0)
+      throw Exception("Error building texture atlas; Atlas has already been built", __FILE__, __LINE__);
+
+   const size_t BPP = 4;
+
+   vector<byte_t> data(m_width * m_height * BPP, 0);
+
+   for (uint_t i = 0; i < m_entries.size(); ++i) {
+      pTexture_t texture = m_entries[i].texture.lock();
+      if (!texture) continue;
+
+      Renderer::int_t w = texture->getWidth();
+      Renderer::int_t h = texture->getHeight();
+      const byte_t* src = texture->getData();
+
+      for (Renderer::int_t r = -m_padding; r < h + m_padding; ++r) {
+         Renderer::int_t srcRow = r < 0 ? 0 : (r >= h ? h - 1 : r);
+
+         byte_t* dest = &data[((m_entries[i].y + r) * m_width + m_entries[i].x) * BPP];
+         const byte_t* row = src + srcRow * w * BPP;
+
+         for (Renderer::int_t c = 1; c <= m_padding; ++c) {
+            memcpy(dest - c * BPP, row, BPP);
+            memcpy(dest + (w + c - 1) * BPP, row + (w - 1) * BPP, BPP);
+         }
+
+         memcpy(dest, row, w * BPP);
+      }
+   }
+
+   m_renderer.loadTexture(&data[0], m_width, m_height, &m_handle);
+
+   for (uint_t i = 0; i < m_entries.size(); ++i) {
+      pTexture_t texture = m_entries[i].texture.lock();
+      if (!texture) continue;
+
+      texture->setAtlas(m_handle, m_width, m_height, m_entries[i].x, m_entries[i].y);
+   }
+}
+
+//===========================================
+// TextureAtlas::~TextureAtlas
+//===========================================
+TextureAtlas::~TextureAtlas() {
+   if (m_handle == 0) return;
+
+   for (uint_t i = 0; i < m_entries.size(); ++i) {
+      pTexture_t texture = m_entries[i].texture.lock();
+      if (texture) texture->setAtlas(0, 0, 0, 0, 0);
+   }
+
+   m_renderer.unloadTexture(m_handle);
+}
+
+
+}
@@ -0,0 +1,464 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <renderer/headless/Renderer.hpp>
+#include <renderer/RendererException.hpp>
+#include <renderer/Model.hpp>
+#include <renderer/SceneGraph.hpp>
+#include <renderer/RenderRules.hpp>
+#include <StringId.hpp>
+#include <Timer.hpp>
+#include <KvpParser.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+Renderer* Renderer::m_instance = NULL;
+THREAD_LOCAL DrawList* Renderer::m_drawRedirect = NULL;
+
+
+//===========================================
+// Renderer::Renderer
+//===========================================
+Renderer::Renderer()
+   : m_sceneGraph(new SceneGraph),
+     m_cullRectValid(false),
+     m_frameModelsSubmitted(0),
+     m_frameModelsCulled(0),
+     m_modelsSubmitted(0),
+     m_modelsCulled(0),
+     m_checksum(0),
+     m_drawCalls(0),
+     m_drawCallsSaved(0),
+     m_framesPresented(0),
+     m_nextTextureHandle(1),
+     m_texturesLoaded(0),
+     m_camera(new Camera(1.f, 1.f)),
+     m_running(false)
+#ifdef DEBUG
+   , m_frameRate(0)
+#endif
+     {}
+
+//===========================================
+// Renderer::loadSettingsFromFile
+//
+// Settings files written for other implementations are accepted. Options that
+// have no meaning here are ignored.
+//===========================================
+void Renderer::loadSettingsFromFile(const string& file) {
+   try {
+      assert(!m_running);
+
+      KvpParser parser;
+
+      parser.parseFile(file);
+
+      string batching = parser.getValue("batching");
+      if (batching == "true") {
+         m_usrReqSettings.batching = true;
+      }
+      else if (batching == "false") {
+         m_usrReqSettings.batching = false;
+      }
+      else if (batching == "") {}
+      else
+         throw RendererException("Error loading renderer settings; Invalid value '"
+            + batching + "' received for 'batching' option.", __FILE__, __LINE__);
+
+      string guardBand = parser.getValue("cull_guard_band");
+      if (guardBand != "") {
+         char* end = NULL;
+         float32_t margin = static_cast<float32_t>(strtod(guardBand.c_str(), &end));
+
+         if (*end != '\0' || margin < 0.f)
+            throw RendererException("Error loading renderer settings; Invalid value '"
+               + guardBand + "' received for 'cull_guard_band' option.", __FILE__, __LINE__);
+
+         m_usrReqSettings.cullGuardBand = margin;
+      }
+   }
+   catch (Exception& e) {
+      RendererException ex("Error loading renderer settings; Bad file; ", __FILE__, __LINE__);
+      ex.append(e.what());
+      throw ex;
+   }
+   catch (...) {
+      throw RendererException("Error loading renderer settings; Bad file", __FILE__, __LINE__);
+   }
+}
+
+//===========================================
+// Renderer::start
+//
+// There's no render thread or GL context, so neither function is called.
+//===========================================
+void Renderer::start(Functor<void, TYPELIST_0()>, Functor<void, TYPELIST_0()>) {
+   m_running = true;
+}
+
+//===========================================
+// Renderer::stop
+//===========================================
+void Renderer::stop() {
+   m_running = false;
+}
+
+//===========================================
+// Renderer::tick
+//
+// Processes the frame immediately, on the calling thread. Draw calls for the
+// next frame can be made once this returns.
+//===========================================
+void Renderer::tick(const Colour& bgColour) {
+   Timer frameTimer;
+   Timer timer;
+
+   lock_guard<mutex> lock(m_drawMutex);
+
+   double waitTime = timer.getTime();
+
+   mergeDrawLists();
+
+   timer.reset();
+   m_sceneGraph->sort();
+   double sortTime = timer.getTime();
+
+   m_modelsSubmitted = m_frameModelsSubmitted;
+   m_modelsCulled = m_frameModelsCulled;
+
+   m_frameModelsSubmitted = 0;
+   m_frameModelsCulled = 0;
+
+   long vertices = 0;
+
+   timer.reset();
+   render(bgColour, vertices);
+   double submitTime = timer.getTime();
+
+   if (m_profiler.isEnabled()) {
+      RenderProfiler::frameStats_t& stats = m_frameStats;
+
+      stats.frame = m_framesPresented;
+      stats.values[RenderProfiler::SORT_TIME] = sortTime * 1000.0;
+      stats.values[RenderProfiler::TICK_WAIT_TIME] = waitTime * 1000.0;
+      stats.values[RenderProfiler::SUBMIT_TIME] = submitTime * 1000.0;
+      stats.values[RenderProfiler::FRAME_TIME] = frameTimer.getTime() * 1000.0;
+      stats.values[RenderProfiler::DRAW_CALLS] = m_drawCalls;
+      stats.values[RenderProfiler::VERTICES] = vertices;
+
+      m_profiler.record(stats);
+   }
+
+   m_frameStats = RenderProfiler::frameStats_t();
+
+   m_sceneGraph->clear();
+   m_modelCache.endFrame();
+   m_cullRectValid = false;
+
+   ++m_framesPresented;
+#ifdef DEBUG
+   computeFrameRate();
+#endif
+}
+
+//===========================================
+// Renderer::draw
+//===========================================
+void Renderer::draw(const IModel* model) {
+   if (m_drawRedirect) {
+      m_drawRedirect->draw(model);
+      return;
+   }
+
+   lock_guard<mutex> lock(m_drawMutex);
+   addToFrame(model);
+}
+
+//===========================================
+// Renderer::submit
+//
+// Queues the list to be merged into the frame at the next tick(). May be
+// called from any thread.
+//===========================================
+void Renderer::submit(DrawList& list) {
+   lock_guard<mutex> lock(m_drawMutex);
+   m_drawLists.push_back(&list);
+}
+
+//===========================================
+// compareDrawLists
+//===========================================
+static bool compareDrawLists(const DrawList* a, const DrawList* b) {
+   return a->getOrder() < b->getOrder();
+}
+
+//===========================================
+// Renderer::mergeDrawLists
+//
+// Adds the models in the submitted lists to the frame, in order, and clears
+// the lists. Must be called with m_drawMutex locked.
+//===========================================
+void Renderer::mergeDrawLists() {
+   stable_sort(m_drawLists.begin(), m_drawLists.end(), compareDrawLists);
+
+   for (uint_t i = 0; i < m_drawLists.size(); ++i) {
+      DrawList& list = *m_drawLists[i];
+
+      for (uint_t j = 0; j < list.getNumModels(); ++j)
+         addToFrame(list.getModel(j));
+
+      list.clear();
+   }
+
+   m_drawLists.clear();
+}
+
+//===========================================
+// Renderer::addToFrame
+//
+// Baked models are skipped, as their StaticGeometry draws them. Must be called
+// with m_drawMutex locked.
+//===========================================
+void Renderer::addToFrame(const IModel* model) {
+   if (model->isBaked()) return;
+
+   if (!isVisible(model)) {
+      ++m_frameModelsCulled;
+      return;
+   }
+
+   if (m_profiler.isEnabled()) {
+      Timer timer;
+
+      size_t bytes = insertModel(model);
+
+      m_frameStats.values[RenderProfiler::INSERT_TIME] += timer.getTime() * 1000.0;
+      m_frameStats.values[RenderProfiler::SCRATCH_BYTES] += bytes;
+   }
+   else {
+      insertModel(model);
+   }
+
+   ++m_frameModelsSubmitted;
+}
+
+//===========================================
+// Renderer::insertModel
+//
+// Adds the model to the scene graph being updated. Models that aren't dynamic
+// are taken from m_modelCache, so are only copied if they've changed since they
+// were last drawn. Returns the number of bytes copied.
+//===========================================
+size_t Renderer::insertModel(const IModel* model) {
+   SceneGraph& sceneGraph = *m_sceneGraph;
+
+   if (model->isDynamic()) {
+      sceneGraph.insert(model);
+      return model->getTotalSize();
+   }
+
+   bool copied;
+   sceneGraph.insert(m_modelCache.getSnapshot(model, copied));
+
+   return copied ? model->getTotalSize() : 0;
+}
+
+
+//===========================================
+// Renderer::isVisible
+//
+// Must be called with m_drawMutex locked.
+//===========================================
+bool Renderer::isVisible(const IModel* model) {
+   if (!m_cullRectValid) {
+      RenderRules::getCullRect(*m_camera, m_usrReqSettings.cullGuardBand, m_cullRect);
+      m_cullRectValid = true;
+   }
+
+   return RenderRules::isVisible(model, m_cullRect);
+}
+
+//===========================================
+// Renderer::render
+//
+// Records the draw calls for the frame and computes its checksum. Must be
+// called with m_drawMutex locked.
+//===========================================
+void Renderer::render(const Colour& bgColour, long& vertices) {
+   m_commands.clear();
+
+   // FNV-1a offset basis
+   m_checksum = 14695981039346656037ULL;
+
+   hash(&bgColour.r, 4 * sizeof(float32_t));
+
+   cml::matrix44f_c P;
+   m_camera->getMatrix(P);
+   hash(P.data(), 16 * sizeof(float32_t));
+
+   long drawCalls = 0;
+   long drawCallsSaved = 0;
+
+   for (auto i = m_sceneGraph->begin(); i != m_sceneGraph->end(); ++i) {
+      const IModel* model = *i;
+
+      if (model->getNumVertices() == 0) continue;
+
+      vertices += model->getNumVertices();
+
+      mode_t mode = model->getRenderMode();
+      primitive_t primitive = model->getPrimitiveType();
+      textureHandle_t texture = model->getTextureHandle();
+      int_t lineWidth = model->getLineWidth();
+      Colour colour = model->getColour();
+
+      hash(&mode, sizeof(mode));
+      hash(&primitive, sizeof(primitive));
+      hash(&texture, sizeof(texture));
+      hash(&lineWidth, sizeof(lineWidth));
+      hash(&colour.r, 4 * sizeof(float32_t));
+      hash(model->m_matrix, 16 * sizeof(matrixElement_t));
+      hash(model->getTextureRect(), 4 * sizeof(texCoordElement_t));
+      hash(model->getVertexData(), model->vertexDataSize());
+
+      if (!m_batch.empty() && !canBatch(m_batch.back(), model)) {
+         drawCallsSaved += recordBatch();
+         ++drawCalls;
+      }
+
+      m_batch.push_back(model);
+   }
+
+   if (!m_batch.empty()) {
+      drawCallsSaved += recordBatch();
+      ++drawCalls;
+   }
+
+   m_drawCalls = drawCalls;
+   m_drawCallsSaved = drawCallsSaved;
+}
+
+//===========================================
+// Renderer::hash
+//
+// Adds the data to m_checksum (64-bit FNV-1a).
+//===========================================
+void Renderer::hash(const void* data, size_t size) {
+   const byte_t* bytes = reinterpret_cast<const byte_t*>(data);
+
+   for (size_t i = 0; i < size; ++i) {
+      m_checksum ^= bytes[i];
+      m_checksum *= 1099511628211ULL;
+   }
+}
+
+//===========================================
+// Renderer::canBatch
+//===========================================
+bool Renderer::canBatch(const IModel* a, const IModel* b) const {
+   return m_usrReqSettings.batching && RenderRules::canBatch(a, b);
+}
+
+//===========================================
+// Renderer::recordBatch
+//
+// Records the models in m_batch as a single draw call and clears m_batch.
+// Returns the number of draw calls saved.
+//===========================================
+uint_t Renderer::recordBatch() {
+   if (m_batch.empty()) return 0;
+
+   const IModel* front = m_batch.front();
+
+   command_t cmd;
+   cmd.mode = front->getRenderMode();
+   cmd.primitiveType = front->getPrimitiveType();
+   cmd.texture = front->getTextureHandle();
+   cmd.numModels = m_batch.size();
+   cmd.numVertices = 0;
+
+   for (uint_t i = 0; i < m_batch.size(); ++i)
+      cmd.numVertices += m_batch[i]->getNumVertices();
+
+   m_commands.push_back(cmd);
+
+   uint_t saved = m_batch.size() - 1;
+   m_batch.clear();
+
+   return saved;
+}
+
+//===========================================
+// Renderer::onWindowResize
+//===========================================
+void Renderer::onWindowResize(int_t, int_t) {}
+
+//===========================================
+// Renderer::bufferModel
+//
+// Vertex data is read straight from the scene graph, so there's nothing to
+// buffer.
+//===========================================
+void Renderer::bufferModel(IModel*) {}
+
+//===========================================
+// Renderer::freeBufferedModel
+//===========================================
+void Renderer::freeBufferedModel(IModel*) {}
+
+//===========================================
+// Renderer::loadTextureAsync
+//
+// Allocates a handle. The texture data isn't read.
+//===========================================
+Renderer::textureFuture_t Renderer::loadTextureAsync(const textureData_t*, int_t, int_t) {
+   promise<textureHandle_t> retVal;
+
+   retVal.set_value(m_nextTextureHandle++);
+   ++m_texturesLoaded;
+
+   return retVal.get_future().share();
+}
+
+//===========================================
+// Renderer::loadTexture
+//===========================================
+void Renderer::loadTexture(const textureData_t* texture, int_t width, int_t height, textureHandle_t* handle) {
+   *handle = loadTextureAsync(texture, width, height).get();
+}
+
+//===========================================
+// Renderer::unloadTexture
+//===========================================
+void Renderer::unloadTexture(textureHandle_t handle) {
+   if (handle != 0) --m_texturesLoaded;
+}
+
+#ifdef DEBUG
+//===========================================
+// Renderer::computeFrameRate
+//===========================================
+void Renderer::computeFrameRate() {
+   static Timer timer;
+   static long i = 0;
+   i++;
+
+   if (i % 10 == 0) {
+      m_frameRate = static_cast<long>(10.0 / timer.getTime());
+      timer.reset();
+   }
+}
+#endif
+
+
+}
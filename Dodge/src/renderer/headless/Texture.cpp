@@ -0,0 +1,153 @@
+/*
+ * Author: Rob Jinman <admin@robjinman.com>
+ * Date: 2013
+ */
+
+#include <cstring>
+#include <sstream>
+#include <renderer/headless/Texture.hpp>
+#include <renderer/headless/Renderer.hpp>
+#include <PNG_CHECK.hpp>
+#include <StringId.hpp>
+#include <globals.hpp>
+
+
+using namespace std;
+
+
+namespace Dodge {
+
+
+//===========================================
+// Texture::Texture
+//===========================================
+Texture::Texture(const char* file)
+   : Asset(internString("Texture")),
+     m_atlasHandle(0),
+     m_atlasW(0),
+     m_atlasH(0),
+     m_atlasX(0),
+     m_atlasY(0),
+     m_renderer(Renderer::getInstance()) {
+
+   pngInit();
+   constructTexture(file);
+}
+
+//===========================================
+// Texture::Texture
+//===========================================
+Texture::Texture(const XmlNode data)
+   : Asset(internString("Texture")),
+     m_atlasHandle(0),
+     m_atlasW(0),
+     m_atlasH(0),
+     m_atlasX(0),
+     m_atlasY(0),
+     m_renderer(Renderer::getInstance()) {
+
+   try {
+      XML_NODE_CHECK(data, Texture);
+
+      pngInit();
+
+      XmlAttribute attr = data.firstAttribute();
+      XML_ATTR_CHECK(attr, path);
+
+      stringstream ss;
+      ss << gGetWorkingDir() << "/" << attr.getString();
+
+      string path = ss.str();
+
+      constructTexture(path.data());
+   }
+   catch (XmlException& e) {
+      e.prepend("Error parsing XML for instance of class Texture; ");
+      throw;
+   }
+}
+
+//===========================================
+// Texture::constructTexture
+//===========================================
+void Texture::constructTexture(const char* file) {
+   PNG_CHECK(png_open_file(&m_png, file));
+
+   size_t bytes = m_png.bpp * m_png.width * m_png.height;
+   m_data = new byte_t[bytes]();
+
+   PNG_CHECK(png_get_data(&m_png, m_data));
+
+   m_width = m_png.width;
+   m_height = m_png.height;
+
+   PNG_CHECK(png_close_file(&m_png));
+
+   m_handle = m_renderer.loadTextureAsync(m_data, m_png.width, m_png.height);
+}
+
+//===========================================
+// Texture::setAtlas
+//
+// The texture's own handle is kept, so models built before the atlas
+// continue to draw correctly until they're next updated.
+//===========================================
+void Texture::setAtlas(uint32_t handle, int32_t w, int32_t h, int32_t x, int32_t y) {
+   m_atlasHandle = handle;
+   m_atlasW = w;
+   m_atlasH = h;
+   m_atlasX = x;
+   m_atlasY = y;
+}
+
+//===========================================
+// Texture::mapSection
+//
+// Converts a section of this texture to the equivalent section of the
+// texture referred to by getHandle(). As elsewhere, y is measured from the
+// bottom of the image.
+//===========================================
+Range Texture::mapSection(const Range& section) const {
+   if (m_atlasHandle == 0) return section;
+
+   Vec2f offset(static_cast<float32_t>(m_atlasX), static_cast<float32_t>(m_atlasH - m_atlasY - m_height));
+   return Range(section.getPosition() + offset, section.getSize());
+}
+
+//===========================================
+// Texture::getSize
+//===========================================
+size_t Texture::getSize() const {
+   return sizeof(Texture) + m_width * m_height * 4;
+}
+
+//===========================================
+// Texture::clone
+//===========================================
+Asset* Texture::clone() const {
+   throw Exception("Cannot clone Texture objects; Feature not implemented", __FILE__, __LINE__);
+}
+
+//===========================================
+// Texture::pngInit
+//===========================================
+void Texture::pngInit() const {
+   static bool init = false;
+
+   if (!init) {
+      PNG_CHECK(png_init(0, 0));
+      init = true;
+   }
+}
+
+//===========================================
+// Texture::~Texture
+//===========================================
+Texture::~Texture() {
+   m_renderer.unloadTexture(m_handle.get());
+
+   delete[] m_data;
+}
+
+
+}
@@ -23,9 +23,9 @@ FixedFunctionMode::FixedFunctionMode() {}
 // FixedFunctionMode::setActive
 //===========================================
 void FixedFunctionMode::setActive() {
-   GL_CHECK(glEnable(GL_TEXTURE_2D));
-   GL_CHECK(glEnable(GL_BLEND));
-   GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+   GL_CHECK(m_gl.enable(GL_TEXTURE_2D));
+   GL_CHECK(m_gl.enable(GL_BLEND));
+   GL_CHECK(m_gl.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 }
 
 //===========================================
@@ -48,7 +48,7 @@ bool FixedFunctionMode::isSupported(const IModel* model) const {
 //===========================================
 // FixedFunctionMode::sendData
 //===========================================
-void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo) {
+void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo, size_t vboOffset) {
    static long vvv = internString("vvv");
    static long vvvcccc = internString("vvvcccc");
    static long vvvtt = internString("vvvtt");
@@ -63,6 +63,18 @@ void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat
    glMatrixMode(GL_PROJECTION);
    glLoadMatrixf(projMat.data());
 
+   // Map texture coordinates into the model's texture rect
+   const Renderer::texCoordElement_t* r = model->getTextureRect();
+   GLfloat texMat[] = {
+      r[2],    0.f,     0.f,     0.f,
+      0.f,     r[3],    0.f,     0.f,
+      0.f,     0.f,     1.f,     0.f,
+      r[0],    r[1],    0.f,     1.f
+   };
+
+   glMatrixMode(GL_TEXTURE);
+   glLoadMatrixf(texMat);
+
    glMatrixMode(GL_MODELVIEW);
    glLoadMatrixf(model_getMatrix(*model));
 
@@ -76,14 +88,14 @@ void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat
       GL_CHECK(glDisableClientState(GL_COLOR_ARRAY));
       GL_CHECK(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
       GL_CHECK(glColor4f(col.r, col.g, col.b, col.a));
-      GL_CHECK(glDisable(GL_TEXTURE_2D));
+      GL_CHECK(m_gl.disable(GL_TEXTURE_2D));
    }
    else if (vertLayout == vvvcccc) {
       stride = sizeof(vvvcccc_t);
       GL_CHECK(glEnableClientState(GL_VERTEX_ARRAY));
       GL_CHECK(glEnableClientState(GL_COLOR_ARRAY));
       GL_CHECK(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
-      GL_CHECK(glDisable(GL_TEXTURE_2D));
+      GL_CHECK(m_gl.disable(GL_TEXTURE_2D));
    }
    else if (vertLayout == vvvtt) {
       stride = sizeof(vvvtt_t);
@@ -91,16 +103,16 @@ void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat
       GL_CHECK(glDisableClientState(GL_COLOR_ARRAY));
       GL_CHECK(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
       GL_CHECK(glColor4f(col.r, col.g, col.b, col.a));
-      GL_CHECK(glEnable(GL_TEXTURE_2D));
-      GL_CHECK(glBindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
+      GL_CHECK(m_gl.enable(GL_TEXTURE_2D));
+      GL_CHECK(m_gl.bindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
    }
    else if (vertLayout == vvvttcccc) {
-      stride = sizeof(vvvttcccc);
+      stride = sizeof(vvvttcccc_t);
       GL_CHECK(glEnableClientState(GL_VERTEX_ARRAY));
       GL_CHECK(glEnableClientState(GL_COLOR_ARRAY));
       GL_CHECK(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
-      GL_CHECK(glEnable(GL_TEXTURE_2D));
-      GL_CHECK(glBindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
+      GL_CHECK(m_gl.enable(GL_TEXTURE_2D));
+      GL_CHECK(m_gl.bindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
    }
 
    assert(stride > 0);
@@ -122,7 +134,7 @@ void FixedFunctionMode::sendData(const IModel* model, const matrix44f_c& projMat
    else {
       GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, vbo));
 
-      GLuint offset = 0;
+      size_t offset = vboOffset;
 
       GL_CHECK(glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<const void*>(offset)));
       offset += 3 * sizeof(GLfloat);
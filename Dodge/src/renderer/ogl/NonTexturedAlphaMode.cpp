@@ -55,13 +55,6 @@ NonTexturedAlphaMode::NonTexturedAlphaMode() {
    RenderMode::newShaderFromSource(fragShader, GL_FRAGMENT_SHADER, m_id);
 
    GL_CHECK(m_gl.linkProgram(m_id));
-}
-
-//===========================================
-// NonTexturedAlphaMode::setActive
-//===========================================
-void NonTexturedAlphaMode::setActive() {
-   GL_CHECK(m_gl.useProgram(m_id));
 
    m_locPosition = GL_CHECK(m_gl.getAttribLocation(m_id, "av4position"));
    m_locColour = GL_CHECK(m_gl.getAttribLocation(m_id, "av4colour"));
@@ -70,12 +63,19 @@ void NonTexturedAlphaMode::setActive() {
    m_locUniColour = GL_CHECK(m_gl.getUniformLocation(m_id, "uniColour"));
    m_locMV = GL_CHECK(m_gl.getUniformLocation(m_id, "mv"));
    m_locP = GL_CHECK(m_gl.getUniformLocation(m_id, "p"));
+}
+
+//===========================================
+// NonTexturedAlphaMode::setActive
+//===========================================
+void NonTexturedAlphaMode::setActive() {
+   GL_CHECK(m_gl.useProgram(m_id));
 
    GL_CHECK(m_gl.enableVertexAttribArray(m_locPosition));
    GL_CHECK(m_gl.enableVertexAttribArray(m_locColour));
 
-   GL_CHECK(glEnable(GL_BLEND));
-   GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+   GL_CHECK(m_gl.enable(GL_BLEND));
+   GL_CHECK(m_gl.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 }
 
 //===========================================
@@ -94,7 +94,7 @@ bool NonTexturedAlphaMode::isSupported(const IModel* model) const {
 //===========================================
 // NonTexturedAlphaMode::sendData
 //===========================================
-void NonTexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo) {
+void NonTexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo, size_t vboOffset) {
    if (!isSupported(model))
       throw RendererException("Model type not supported by NonTexturedAlphaMode", __FILE__, __LINE__);
 
@@ -107,7 +107,7 @@ void NonTexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& proj
 
    if (model->getPrimitiveType() == Renderer::LINES) {
       if (model->getLineWidth() != 0)
-         GL_CHECK(glLineWidth(static_cast<GLfloat>(model->getLineWidth())));
+         GL_CHECK(m_gl.lineWidth(static_cast<GLfloat>(model->getLineWidth())));
    }
 
    // If model contains per-vertex colour data
@@ -138,7 +138,7 @@ void NonTexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& proj
    else {
       GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, vbo));
 
-      GLuint offset = 0;
+      size_t offset = vboOffset;
 
       GL_CHECK(m_gl.vertexAttribPointer(m_locPosition, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offset)));
       offset += 3 * sizeof(Renderer::vertexElement_t);
@@ -5,6 +5,38 @@ namespace Dodge {
 
 
 oglSupport_t OglWrapper::m_oglSupport;
+OglWrapper::glState_t OglWrapper::m_state;
+long OglWrapper::m_callsIssued = 0;
+long OglWrapper::m_callsElided = 0;
+long OglWrapper::m_programSwitches = 0;
+long OglWrapper::m_textureSwitches = 0;
+
+
+//===========================================
+// OglWrapper::invalidateStateCache
+//
+// Marks all cached state as unknown, so the next call to set any of it is
+// always passed on to GL.
+//===========================================
+void OglWrapper::invalidateStateCache() const {
+   const GLuint UNKNOWN = static_cast<GLuint>(-1);
+
+   m_state.program = UNKNOWN;
+   m_state.arrayBuffer = UNKNOWN;
+   m_state.texture2d = UNKNOWN;
+   m_state.blendSrc = UNKNOWN;
+   m_state.blendDst = UNKNOWN;
+   m_state.lineWidth = -1.f;
+   m_state.caps.clear();
+
+   for (GLuint i = 0; i < MAX_VERTEX_ATTRIBS; ++i) {
+      m_state.attribEnabled[i] = -1;
+      m_state.attribPointers[i].valid = false;
+   }
+
+   m_state.uniforms.clear();
+   m_state.activeUniforms = NULL;
+}
 
 
 }
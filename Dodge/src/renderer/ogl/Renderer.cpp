@@ -5,10 +5,13 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <algorithm>
+#include <chrono>
 #include <renderer/ogl/Renderer.hpp>
 #include <renderer/RendererException.hpp>
 #include <renderer/Model.hpp>
 #include <renderer/SceneGraph.hpp>
+#include <renderer/RenderRules.hpp>
 #include <renderer/ogl/RenderMode.hpp>
 #include <renderer/GL_CHECK.hpp>
 #include <Timer.hpp>
@@ -23,23 +26,66 @@ namespace Dodge {
 
 
 Renderer* Renderer::m_instance = NULL;
+THREAD_LOCAL DrawList* Renderer::m_drawRedirect = NULL;
 
 
+//===========================================
+// transformVertex
+//===========================================
+template <class T>
+static inline void transformVertex(const Renderer::matrixElement_t* m, T& vert) {
+   Renderer::vertexElement_t x = vert.v1;
+   Renderer::vertexElement_t y = vert.v2;
+   Renderer::vertexElement_t z = vert.v3;
+
+   vert.v1 = m[0] * x + m[4] * y + m[8] * z + m[12];
+   vert.v2 = m[1] * x + m[5] * y + m[9] * z + m[13];
+   vert.v3 = m[2] * x + m[6] * y + m[10] * z + m[14];
+}
+
+//===========================================
+// mapTexCoords
+//===========================================
+template <class T>
+static inline void mapTexCoords(const Renderer::texCoordElement_t* rect, T& vert) {
+   vert.t1 = rect[0] + vert.t1 * rect[2];
+   vert.t2 = rect[1] + vert.t2 * rect[3];
+}
+
 //===========================================
 // Renderer::Renderer
 //===========================================
 Renderer::Renderer()
    : m_swapBuffers(dummySwapFunc),
      m_makeGLContext(dummyMakeGLContextFunc),
+     m_nextVboSlot(0),
      m_activeRenderMode(NULL),
      m_mode(UNDEFINED),
      m_init(false),
      m_frameNumber(0),
+     m_renderThreadWaiting(false),
+     m_redrawRequired(true),
+     m_framesPresented(0),
+     m_framesDuplicated(0),
+     m_cullRectValid(false),
+     m_frameModelsSubmitted(0),
+     m_frameModelsCulled(0),
+     m_modelsSubmitted(0),
+     m_modelsCulled(0),
+     m_batchSpace(65536),
+     m_streamVbo(0),
+     m_streamBufferSize(STREAM_BUFFER_SIZE),
+     m_streamOffset(0),
+     m_drawCalls(0),
+     m_drawCallsSaved(0),
+     m_glCallsIssued(0),
+     m_glCallsElided(0),
      m_camera(new Camera(1.f, 1.f)),
      m_running(false),
      m_thread(NULL),
-     m_scratchSpace(1024),
-     m_msgQueueEmpty(true),
+     m_msgQueue(MSG_QUEUE_SIZE),
+     m_msgPayloads(MSG_PAYLOAD_SIZE),
+     m_stopped(false),
      m_exception(UNKNOWN_EXCEPTION, NULL),
      m_errorPending(false)
 #ifdef DEBUG
@@ -100,6 +146,54 @@ void Renderer::loadSettingsFromFile(const string& file) {
       else
          throw RendererException("Error loading renderer settings; Invalid value '"
             + vbos + "' received for 'VBOs' option.", __FILE__, __LINE__);
+
+      string batching = parser.getValue("batching");
+      if (batching == "true") {
+         m_usrReqSettings.batching = true;
+      }
+      else if (batching == "false") {
+         m_usrReqSettings.batching = false;
+      }
+      else if (batching == "") {}
+      else
+         throw RendererException("Error loading renderer settings; Invalid value '"
+            + batching + "' received for 'batching' option.", __FILE__, __LINE__);
+
+      string guardBand = parser.getValue("cull_guard_band");
+      if (guardBand != "") {
+         char* end = NULL;
+         float32_t margin = static_cast<float32_t>(strtod(guardBand.c_str(), &end));
+
+         if (*end != '\0' || margin < 0.f)
+            throw RendererException("Error loading renderer settings; Invalid value '"
+               + guardBand + "' received for 'cull_guard_band' option.", __FILE__, __LINE__);
+
+         m_usrReqSettings.cullGuardBand = margin;
+      }
+
+      string renderOnChange = parser.getValue("render_on_change");
+      if (renderOnChange == "true") {
+         m_usrReqSettings.renderOnChange = true;
+      }
+      else if (renderOnChange == "false") {
+         m_usrReqSettings.renderOnChange = false;
+      }
+      else if (renderOnChange == "") {}
+      else
+         throw RendererException("Error loading renderer settings; Invalid value '"
+            + renderOnChange + "' received for 'render_on_change' option.", __FILE__, __LINE__);
+
+      string maxFps = parser.getValue("max_frame_rate");
+      if (maxFps != "") {
+         char* end = NULL;
+         long fps = strtol(maxFps.c_str(), &end, 10);
+
+         if (*end != '\0' || fps < 0)
+            throw RendererException("Error loading renderer settings; Invalid value '"
+               + maxFps + "' received for 'max_frame_rate' option.", __FILE__, __LINE__);
+
+         m_usrReqSettings.maxFrameRate = static_cast<int_t>(fps);
+      }
    }
    catch (Exception& e) {
       RendererException ex("Error loading renderer settings; Bad file; ", __FILE__, __LINE__);
@@ -119,6 +213,11 @@ void Renderer::start(Functor<void, TYPELIST_0()> makeGLContextFunc, Functor<void
       m_makeGLContext = makeGLContextFunc;
       m_swapBuffers = swapFunc;
 
+      {
+         lock_guard<mutex> lock(m_msgQueueMutex);
+         m_stopped = false;
+      }
+
       m_running = true;
       m_thread = new thread(&Renderer::renderLoop, this);
    }
@@ -126,13 +225,29 @@ void Renderer::start(Functor<void, TYPELIST_0()> makeGLContextFunc, Functor<void
 
 //===========================================
 // Renderer::stop
+//
+// Messages still in the queue are discarded, and any texture requests among
+// them fail.
 //===========================================
 void Renderer::stop() {
    if (m_running) {
-      m_running = false;
+      {
+         lock_guard<mutex> lock(m_stateChangeMutex);
+         m_running = false;
+      }
+
+      m_cvRender.notify_one();
+
       m_thread->join();
       delete m_thread;
       m_thread = NULL;
+
+      {
+         lock_guard<mutex> lock(m_msgQueueMutex);
+         m_stopped = true;
+      }
+
+      discardMessages();
    }
 }
 
@@ -146,7 +261,50 @@ void Renderer::stop() {
 void Renderer::tick(const Colour& bgColour) {
    checkForErrors();
 
+   {
+      lock_guard<mutex> lock(m_drawMutex);
+      mergeDrawLists();
+   }
+
+   bool profiling = m_profiler.isEnabled();
+   Timer timer;
+
+   // Put the frame's models in draw order before handing it to the render thread.
+   m_state[m_idxUpdate].sceneGraph->sort();
+
+   double sortTime = timer.getTime();
+   double waitTime = 0.0;
+
+   {
+      timer.reset();
+      lock_guard<mutex> lock(m_drawMutex);
+      waitTime += timer.getTime();
+
+      m_modelsSubmitted = m_frameModelsSubmitted;
+      m_modelsCulled = m_frameModelsCulled;
+
+      m_frameModelsSubmitted = 0;
+      m_frameModelsCulled = 0;
+      m_cullRectValid = false;
+
+      m_modelCache.endFrame();
+   }
+
+   // The frame's projection is taken from the camera once, here, before the
+   // state change lock is taken.
+   cml::matrix44f_c P;
+   m_camera->getMatrix(P);
+
+   timer.reset();
    lock_guard<mutex> lock(m_stateChangeMutex);
+   waitTime += timer.getTime();
+
+   if (profiling) {
+      RenderProfiler::frameStats_t& stats = m_state[m_idxUpdate].stats;
+
+      stats.values[RenderProfiler::SORT_TIME] = sortTime * 1000.0;
+      stats.values[RenderProfiler::TICK_WAIT_TIME] = waitTime * 1000.0;
+   }
 
    // Any states that were pending render are now out of date, and will
    // not be rendered.
@@ -160,7 +318,7 @@ void Renderer::tick(const Colour& bgColour) {
    m_idxLatest = m_idxUpdate;
    m_state[m_idxLatest].status = renderState_t::IS_PENDING_RENDER;
 
-   m_camera->getMatrix(m_state[m_idxLatest].P);
+   m_state[m_idxLatest].P = P;
 
    // Choose a new state for updating.
    m_idxUpdate = -1;
@@ -171,7 +329,31 @@ void Renderer::tick(const Colour& bgColour) {
 
    m_state[m_idxUpdate].sceneGraph->clear();
    m_state[m_idxUpdate].bgColour = bgColour;
+   m_state[m_idxUpdate].stats = RenderProfiler::frameStats_t();
    m_state[m_idxUpdate].status = renderState_t::IS_BEING_UPDATED;
+
+   m_cvRender.notify_one();
+}
+
+//===========================================
+// Renderer::wakeRenderThread
+//
+// Wakes the render thread if it's waiting for a new frame, so it can
+// process any messages. Called after every message is queued, so the lock is
+// only taken when the render thread is actually waiting.
+//===========================================
+void Renderer::wakeRenderThread() {
+   // Pairs with the fence in renderLoop. Either the render thread will see
+   // the message before it waits, or we'll see that it's waiting.
+   atomic_thread_fence(memory_order_seq_cst);
+
+   if (!m_renderThreadWaiting.load(memory_order_relaxed)) return;
+
+   // Ensures the render thread is either waiting or has yet to check for
+   // messages, so the notification isn't lost.
+   { lock_guard<mutex> lock(m_stateChangeMutex); }
+
+   m_cvRender.notify_one();
 }
 
 //===========================================
@@ -200,87 +382,304 @@ void Renderer::checkForErrors() {
 // Renderer::draw
 //===========================================
 void Renderer::draw(const IModel* model) {
-   m_state[m_idxUpdate].sceneGraph->insert(model);
+   if (m_drawRedirect) {
+      m_drawRedirect->draw(model);
+      return;
+   }
+
+   lock_guard<mutex> lock(m_drawMutex);
+   addToFrame(model);
+}
+
+//===========================================
+// Renderer::submit
+//
+// Queues the list to be merged into the frame at the next tick(). May be
+// called from any thread.
+//===========================================
+void Renderer::submit(DrawList& list) {
+   lock_guard<mutex> lock(m_drawMutex);
+   m_drawLists.push_back(&list);
+}
+
+//===========================================
+// compareDrawLists
+//===========================================
+static bool compareDrawLists(const DrawList* a, const DrawList* b) {
+   return a->getOrder() < b->getOrder();
+}
+
+//===========================================
+// Renderer::mergeDrawLists
+//
+// Adds the models in the submitted lists to the frame, in order, and clears
+// the lists. Must be called with m_drawMutex locked.
+//===========================================
+void Renderer::mergeDrawLists() {
+   stable_sort(m_drawLists.begin(), m_drawLists.end(), compareDrawLists);
+
+   for (uint_t i = 0; i < m_drawLists.size(); ++i) {
+      DrawList& list = *m_drawLists[i];
+
+      for (uint_t j = 0; j < list.getNumModels(); ++j)
+         addToFrame(list.getModel(j));
+
+      list.clear();
+   }
+
+   m_drawLists.clear();
+}
+
+//===========================================
+// Renderer::addToFrame
+//
+// Baked models are skipped, as their StaticGeometry draws them. Must be called
+// with m_drawMutex locked.
+//===========================================
+void Renderer::addToFrame(const IModel* model) {
+   if (model->isBaked()) return;
+
+   if (!isVisible(model)) {
+      ++m_frameModelsCulled;
+      return;
+   }
+
+   if (m_profiler.isEnabled()) {
+      RenderProfiler::frameStats_t& stats = m_state[m_idxUpdate].stats;
+      Timer timer;
+
+      size_t bytes = insertModel(model);
+
+      stats.values[RenderProfiler::INSERT_TIME] += timer.getTime() * 1000.0;
+      stats.values[RenderProfiler::SCRATCH_BYTES] += bytes;
+   }
+   else {
+      insertModel(model);
+   }
+
+   ++m_frameModelsSubmitted;
+}
+
+//===========================================
+// Renderer::insertModel
+//
+// Adds the model to the scene graph being updated. Models that aren't dynamic
+// are taken from m_modelCache, so are only copied if they've changed since they
+// were last drawn. Returns the number of bytes copied.
+//===========================================
+size_t Renderer::insertModel(const IModel* model) {
+   SceneGraph& sceneGraph = *m_state[m_idxUpdate].sceneGraph;
+
+   if (model->isDynamic()) {
+      sceneGraph.insert(model);
+      return model->getTotalSize();
+   }
+
+   bool copied;
+   sceneGraph.insert(m_modelCache.getSnapshot(model, copied));
+
+   return copied ? model->getTotalSize() : 0;
+}
+
+
+//===========================================
+// Renderer::isVisible
+//
+// Must be called with m_drawMutex locked.
+//===========================================
+bool Renderer::isVisible(const IModel* model) {
+   if (!m_cullRectValid) {
+      RenderRules::getCullRect(*m_camera, m_usrReqSettings.cullGuardBand, m_cullRect);
+      m_cullRectValid = true;
+   }
+
+   return RenderRules::isVisible(model, m_cullRect);
 }
 
 //===========================================
 // Renderer::bufferModel
+//
+// The first time a model is buffered it's given a slot in the render thread's
+// table of VBOs, which it keeps until freeBufferedModel() is called.
+//
+// The model is copied through the message payload buffer, so models larger
+// than MSG_PAYLOAD_SIZE (4MB) can't be buffered. They lose any VBO they had
+// and are streamed each frame instead.
 //===========================================
 void Renderer::bufferModel(IModel* model) {
    if (!m_oglSupport.VBOs.available) return;
+   if (model->isDynamic()) return;
+
+   if (model->getTotalSize() > m_msgPayloads.getSize()) {
+      freeBufferedModel(model);
+      return;
+   }
 
    lock_guard<mutex> lock(m_msgQueueMutex);
 
-   size_t totalSize = model->getTotalSize();
+   Message msg;
+   msg.type = MSG_CONSTRUCT_VBO;
+
+   void* ptr = allocMsgPayload(model->getTotalSize(), msg);
+   if (ptr == NULL) return;
+
+   if (model->m_bufferSlot == -1) {
+      if (m_freeVboSlots.empty()) {
+         model->m_bufferSlot = m_nextVboSlot++;
+      }
+      else {
+         model->m_bufferSlot = m_freeVboSlots.back();
+         m_freeVboSlots.pop_back();
+      }
+
+      // So that copies of the model made before now aren't reused
+      ++model->m_version;
+   }
 
-   IModel* ptr = reinterpret_cast<IModel*>(m_scratchSpace.alloc(totalSize));
    model->copyTo(ptr);
+   msg.data.constructVbo.model = reinterpret_cast<IModel*>(ptr);
 
-   msgConstructVbo_t data = { ptr };
-   queueMsg(Message(MSG_CONSTRUCT_VBO, data));
+   queueMsg(msg);
 }
 
 //===========================================
 // Renderer::freeBufferedModel
+//
+// The slot can be handed straight to another model, as the render thread
+// processes messages in order.
 //===========================================
 void Renderer::freeBufferedModel(IModel* model) {
    if (!m_oglSupport.VBOs.available) return;
 
-   lock_guard<mutex> lock1(m_msgQueueMutex);
-   {
-      lock_guard<mutex> lock2(m_vboMapMutex);
+   lock_guard<mutex> lock(m_msgQueueMutex);
 
-      auto i = m_vboMap.find(model->m_id);
-      if (i != m_vboMap.end() && i->second != 0) {
-         msgDestroyVbo_t data = { i->second };
-         queueMsg(Message(MSG_DESTROY_VBO, data));
+   if (model->m_bufferSlot != -1) {
+      Message msg;
+      msg.type = MSG_DESTROY_VBO;
+      msg.hasPayload = false;
+      msg.data.destroyVbo.slot = model->m_bufferSlot;
 
-         i->second = 0;
-      }
+      queueMsg(msg);
+
+      m_freeVboSlots.push_back(model->m_bufferSlot);
+
+      model->m_bufferSlot = -1;
+      ++model->m_version;
    }
 }
 
 //===========================================
 // Renderer::queueMsg
+//
+// Must be called with m_msgQueueMutex locked. If the queue is full, waits for
+// the render thread to make space. Returns false if the message was dropped
+// because the render thread has terminated or isn't running.
 //===========================================
-void Renderer::queueMsg(Message msg) {
-   m_msgQueueEmpty = false;
-   m_msgQueue.push_back(msg);
+bool Renderer::queueMsg(const Message& msg) {
+   if (m_stopped) return false;
+
+   while (!m_msgQueue.push(msg)) {
+      if (m_errorPending || !m_running) return false;
+
+      wakeRenderThread();
+      this_thread::yield();
+   }
+
+   wakeRenderThread();
+
+   return true;
 }
 
 //===========================================
-// Renderer::loadTexture
+// Renderer::allocMsgPayload
+//
+// Must be called with m_msgQueueMutex locked. The returned memory is valid
+// until msg has been processed. Returns NULL if the render thread has
+// terminated or isn't running.
 //===========================================
-void Renderer::loadTexture(const textureData_t* texture, int_t width, int_t height, textureHandle_t* handle) {
-   msgTexHandleReq_t data = { texture, width, height, handle };
+void* Renderer::allocMsgPayload(size_t size, Message& msg) {
+   if (m_stopped) return NULL;
 
-   {
-      lock_guard<mutex> lock(m_msgQueueMutex);
-      queueMsg(Message(MSG_TEX_HANDLE_REQ, data));
+   void* ptr = NULL;
+
+   while ((ptr = m_msgPayloads.alloc(size, msg.payloadEnd)) == NULL) {
+      if (m_errorPending || !m_running) return NULL;
+
+      wakeRenderThread();
+      this_thread::yield();
+   }
+
+   msg.hasPayload = true;
+
+   return ptr;
+}
+
+//===========================================
+// Renderer::loadTextureAsync
+//
+// Queues the texture for upload by the render thread and returns
+// immediately. The texture data must remain valid until the returned future
+// is ready. If the upload fails, or the render thread terminates first,
+// the future holds the exception.
+//===========================================
+Renderer::textureFuture_t Renderer::loadTextureAsync(const textureData_t* texture, int_t width, int_t height) {
+   promise<textureHandle_t>* retVal = new promise<textureHandle_t>;
+   textureFuture_t future = retVal->get_future().share();
+
+   Message msg;
+   msg.type = MSG_TEX_HANDLE_REQ;
+   msg.hasPayload = false;
+   msg.data.texHandleReq.texData = texture;
+   msg.data.texHandleReq.w = width;
+   msg.data.texHandleReq.h = height;
+   msg.data.texHandleReq.retVal = retVal;
+
+   lock_guard<mutex> lock(m_msgQueueMutex);
+
+   if (m_errorPending || !queueMsg(msg)) {
+      retVal->set_exception(make_exception_ptr(
+         RendererException("Error loading texture; Render thread has terminated", __FILE__, __LINE__)));
+
+      delete retVal;
    }
 
-   // Hang until message is processed
-   while (!m_msgQueueEmpty) { if (m_errorPending) break; }
+   return future;
+}
+
+//===========================================
+// Renderer::loadTexture
+//
+// Blocks until the texture has been uploaded.
+//===========================================
+void Renderer::loadTexture(const textureData_t* texture, int_t width, int_t height, textureHandle_t* handle) {
+   *handle = loadTextureAsync(texture, width, height).get();
 }
 
 //===========================================
 // Renderer::unloadTexture
 //===========================================
 void Renderer::unloadTexture(textureHandle_t handle) {
-   msgTexUnloadReq_t data = { handle };
+   Message msg;
+   msg.type = MSG_TEX_UNLOAD_REQ;
+   msg.hasPayload = false;
+   msg.data.texUnloadReq.handle = handle;
 
    lock_guard<mutex> lock(m_msgQueueMutex);
-   queueMsg(Message(MSG_TEX_UNLOAD_REQ, data));
+   queueMsg(msg);
 }
 
 //===========================================
 // Renderer::onWindowResize
 //===========================================
 void Renderer::onWindowResize(int_t x, int_t y) {
-   msgVpResizeReq_t data = { x, y };
+   Message msg;
+   msg.type = MSG_VP_RESIZE_REQ;
+   msg.hasPayload = false;
+   msg.data.vpResizeReq.w = x;
+   msg.data.vpResizeReq.h = y;
 
    lock_guard<mutex> lock(m_msgQueueMutex);
-   queueMsg(Message(MSG_VP_RESIZE_REQ, data));
+   queueMsg(msg);
 }
 
 //===========================================
@@ -341,10 +740,27 @@ void Renderer::init() {
       else
          m_oglSupport.shaders = oglFeature_t(false);
    }
+
+   if (m_oglSupport.VBOs.available && (GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range))
+      m_oglSupport.mapBufferRange = oglFeature_t(true, CORE);
+   else
+      m_oglSupport.mapBufferRange = oglFeature_t(false);
+
+   if (m_oglSupport.VBOs.available && m_oglSupport.shaders.available) {
+      if (m_oglSupport.shaders.nameScheme == CORE && GLEW_VERSION_3_3)
+         m_oglSupport.instancing = oglFeature_t(true, CORE);
+      else if (GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced)
+         m_oglSupport.instancing = oglFeature_t(true, ARB);
+      else
+         m_oglSupport.instancing = oglFeature_t(false);
+   }
+   else
+      m_oglSupport.instancing = oglFeature_t(false);
 #endif
 
 #ifdef GL_FIXED_PIPELINE
    m_oglSupport.shaders = oglFeature_t(false);
+   m_oglSupport.instancing = oglFeature_t(false);
 #endif
 
    GL_CHECK(glEnable(GL_CULL_FACE));
@@ -352,6 +768,12 @@ void Renderer::init() {
 
    m_gl.initialise(m_oglSupport);
 
+   if (m_oglSupport.VBOs.available) {
+      GL_CHECK(m_gl.genBuffers(1, &m_streamVbo));
+      GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, m_streamVbo));
+      GL_CHECK(m_gl.bufferData(GL_ARRAY_BUFFER, m_streamBufferSize, NULL, GL_STREAM_DRAW));
+   }
+
    if (!m_oglSupport.shaders.available) {
       m_activeRenderMode = RenderMode::create(FIXED_FUNCTION);
       m_activeRenderMode->setActive();
@@ -378,6 +800,234 @@ void Renderer::setMode(mode_t mode) {
    m_mode = mode;
 }
 
+//===========================================
+// Renderer::drawModel
+//===========================================
+void Renderer::drawModel(const IModel* model) {
+   setMode(model->getRenderMode());
+
+   GLuint vbo = 0;
+   size_t offset = 0;
+
+   if (m_oglSupport.VBOs.available) {
+      long slot = model->m_bufferSlot;
+
+      if (slot != -1 && slot < static_cast<long>(m_vbos.size()) && m_vbos[slot].modelId == model->m_id)
+         vbo = m_vbos[slot].handle;
+
+      if (vbo == 0) {
+         offset = streamVertexData(model->getVertexData(), model->vertexDataSize());
+         vbo = m_streamVbo;
+      }
+   }
+
+   m_activeRenderMode->sendData(model, m_state[m_idxRender].P, vbo, offset);
+}
+
+//===========================================
+// Renderer::canBatch
+//===========================================
+bool Renderer::canBatch(const IModel* a, const IModel* b) const {
+   return m_usrReqSettings.batching && RenderRules::canBatch(a, b);
+}
+
+//===========================================
+// Renderer::constructTexturedBatch
+//
+// Copies the vertices of each model in m_batch into a single model,
+// transformed into world space. The model and its vertices are allocated
+// from m_batchSpace and so only live until the end of the frame.
+//===========================================
+IModel* Renderer::constructTexturedBatch(uint_t nVerts) {
+   static long vvvttcccc = internString("vvvttcccc");
+
+   byte_t* ptr = reinterpret_cast<byte_t*>(m_batchSpace.alloc(sizeof(Model<vvvttcccc_t>) + nVerts * sizeof(vvvttcccc_t)));
+
+   Model<vvvttcccc_t>* batch = new(ptr) Model<vvvttcccc_t>();
+   vvvttcccc_t* verts = reinterpret_cast<vvvttcccc_t*>(ptr + sizeof(Model<vvvttcccc_t>));
+
+   uint_t idx = 0;
+   for (uint_t i = 0; i < m_batch.size(); ++i) {
+      const IModel* model = m_batch[i];
+      uint_t n = model->getNumVertices();
+
+      const texCoordElement_t* rect = model->getTextureRect();
+
+      if (model->getVertexLayout() == vvvttcccc) {
+         const vvvttcccc_t* src = reinterpret_cast<const vvvttcccc_t*>(model->getVertexData());
+
+         for (uint_t j = 0; j < n; ++j, ++idx) {
+            verts[idx] = src[j];
+            transformVertex(model->m_matrix, verts[idx]);
+            mapTexCoords(rect, verts[idx]);
+         }
+      }
+      else {
+         const vvvtt_t* src = reinterpret_cast<const vvvtt_t*>(model->getVertexData());
+         Colour col = model->getColour();
+
+         for (uint_t j = 0; j < n; ++j, ++idx) {
+            verts[idx] = vvvttcccc_t(src[j].v1, src[j].v2, src[j].v3, src[j].t1, src[j].t2, col.r, col.g, col.b, col.a);
+            transformVertex(model->m_matrix, verts[idx]);
+            mapTexCoords(rect, verts[idx]);
+         }
+      }
+   }
+
+   batch->m_vertLayout = vvvttcccc;
+   batch->m_renderMode = m_batch.front()->getRenderMode();
+   batch->m_texHandle = m_batch.front()->getTextureHandle();
+   batch->m_verts = verts;
+   batch->m_n = nVerts;
+
+   return batch;
+}
+
+//===========================================
+// Renderer::constructNonTexturedBatch
+//
+// As constructTexturedBatch, but for untextured models.
+//===========================================
+IModel* Renderer::constructNonTexturedBatch(uint_t nVerts) {
+   static long vvvcccc = internString("vvvcccc");
+
+   byte_t* ptr = reinterpret_cast<byte_t*>(m_batchSpace.alloc(sizeof(Model<vvvcccc_t>) + nVerts * sizeof(vvvcccc_t)));
+
+   Model<vvvcccc_t>* batch = new(ptr) Model<vvvcccc_t>();
+   vvvcccc_t* verts = reinterpret_cast<vvvcccc_t*>(ptr + sizeof(Model<vvvcccc_t>));
+
+   uint_t idx = 0;
+   for (uint_t i = 0; i < m_batch.size(); ++i) {
+      const IModel* model = m_batch[i];
+      uint_t n = model->getNumVertices();
+
+      if (model->getVertexLayout() == vvvcccc) {
+         const vvvcccc_t* src = reinterpret_cast<const vvvcccc_t*>(model->getVertexData());
+
+         for (uint_t j = 0; j < n; ++j, ++idx) {
+            verts[idx] = src[j];
+            transformVertex(model->m_matrix, verts[idx]);
+         }
+      }
+      else {
+         const vvv_t* src = reinterpret_cast<const vvv_t*>(model->getVertexData());
+         Colour col = model->getColour();
+
+         for (uint_t j = 0; j < n; ++j, ++idx) {
+            verts[idx] = vvvcccc_t(src[j].v1, src[j].v2, src[j].v3, col.r, col.g, col.b, col.a);
+            transformVertex(model->m_matrix, verts[idx]);
+         }
+      }
+   }
+
+   batch->m_vertLayout = vvvcccc;
+   batch->m_renderMode = m_batch.front()->getRenderMode();
+   batch->m_texHandle = m_batch.front()->getTextureHandle();
+   batch->m_verts = verts;
+   batch->m_n = nVerts;
+
+   return batch;
+}
+
+//===========================================
+// Renderer::drawInstanced
+//
+// If every model in m_batch shares the same geometry, draws them as
+// instances of the first, uploading only their matrices, colours and
+// texture rects. Returns false if the batch can't be drawn this way, in
+// which case nothing is drawn or streamed.
+//===========================================
+bool Renderer::drawInstanced() {
+   static long vvvtt = internString("vvvtt");
+
+   if (!m_oglSupport.instancing.available || !m_oglSupport.shaders.available) return false;
+   if (m_streamVbo == 0) return false;
+
+   const IModel* first = m_batch.front();
+
+   if (first->getGeometryId() == 0 || first->getVertexLayout() != vvvtt) return false;
+
+   for (uint_t i = 1; i < m_batch.size(); ++i) {
+      if (m_batch[i]->getGeometryId() != first->getGeometryId()) return false;
+   }
+
+   map<mode_t, RenderMode*>::iterator it = m_renderModes.find(first->getRenderMode());
+   if (it == m_renderModes.end() || !it->second->canDrawInstanced(first)) return false;
+
+   uint_t n = m_batch.size();
+
+   modelInstance_t* instances = reinterpret_cast<modelInstance_t*>(m_batchSpace.alloc(n * sizeof(modelInstance_t)));
+
+   for (uint_t i = 0; i < n; ++i) {
+      const IModel* model = m_batch[i];
+      const Colour& col = model->getColour();
+
+      memcpy(instances[i].mv, model->m_matrix, sizeof(instances[i].mv));
+      memcpy(instances[i].texRect, model->getTextureRect(), sizeof(instances[i].texRect));
+
+      instances[i].colour[0] = col.r;
+      instances[i].colour[1] = col.g;
+      instances[i].colour[2] = col.b;
+      instances[i].colour[3] = col.a;
+   }
+
+   setMode(first->getRenderMode());
+
+   size_t vertOffset = streamVertexData(first->getVertexData(), first->vertexDataSize());
+   size_t instOffset = streamVertexData(instances, n * sizeof(modelInstance_t));
+
+   return m_activeRenderMode->sendInstances(first, m_state[m_idxRender].P, m_streamVbo, vertOffset, n, m_streamVbo, instOffset);
+}
+
+//===========================================
+// Renderer::drawBatch
+//
+// Draws the models in m_batch with a single draw call and clears m_batch.
+// Returns the number of draw calls saved.
+//===========================================
+uint_t Renderer::drawBatch() {
+   static long vvvtt = internString("vvvtt");
+   static long vvvttcccc = internString("vvvttcccc");
+
+   if (m_batch.empty()) return 0;
+
+   if (m_batch.size() == 1) {
+      drawModel(m_batch.front());
+      m_batch.clear();
+
+      return 0;
+   }
+
+   if (drawInstanced()) {
+      uint_t saved = m_batch.size() - 1;
+      m_batch.clear();
+
+      return saved;
+   }
+
+   uint_t nVerts = 0;
+   for (uint_t i = 0; i < m_batch.size(); ++i)
+      nVerts += m_batch[i]->getNumVertices();
+
+   long layout = m_batch.front()->getVertexLayout();
+
+   IModel* batch = layout == vvvtt || layout == vvvttcccc ?
+      constructTexturedBatch(nVerts) : constructNonTexturedBatch(nVerts);
+
+   setMode(batch->getRenderMode());
+
+   size_t offset = 0;
+   if (m_streamVbo != 0)
+      offset = streamVertexData(batch->getVertexData(), batch->vertexDataSize());
+
+   m_activeRenderMode->sendData(batch, m_state[m_idxRender].P, m_streamVbo, offset);
+
+   uint_t saved = m_batch.size() - 1;
+   m_batch.clear();
+
+   return saved;
+}
+
 //===========================================
 // Renderer::constructRenderModes
 //===========================================
@@ -400,7 +1050,7 @@ Renderer::textureHandle_t Renderer::loadGLTexture(const textureData_t* texture,
    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
    GL_CHECK(glGenTextures(1, &texId));
 
-   GL_CHECK(glBindTexture(GL_TEXTURE_2D, texId));
+   GL_CHECK(m_gl.bindTexture(GL_TEXTURE_2D, texId));
 
    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture));
 
@@ -414,67 +1064,123 @@ Renderer::textureHandle_t Renderer::loadGLTexture(const textureData_t* texture,
 // Renderer::constructVbo
 //===========================================
 void Renderer::constructVbo(IModel* model) {
-   lock_guard<mutex> lock(m_vboMapMutex);
+   long slot = model->m_bufferSlot;
 
-   auto i = m_vboMap.find(model->m_id);
+   if (slot >= static_cast<long>(m_vbos.size())) {
+      vbo_t empty = { 0, -1 };
+      m_vbos.resize(slot + 1, empty);
+   }
 
-   if (i != m_vboMap.end() && i->second != 0)
-      destroyVbo(i->second);
+   vbo_t& vbo = m_vbos[slot];
 
-   GLuint handle;
+   // Re-use the model's existing buffer if it has one
+   if (vbo.handle == 0) {
+      GL_CHECK(m_gl.genBuffers(1, &vbo.handle));
+   }
 
-   GL_CHECK(m_gl.genBuffers(1, &handle));
-   GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, handle));
+   GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, vbo.handle));
    GL_CHECK(m_gl.bufferData(GL_ARRAY_BUFFER, model->vertexDataSize(), model->getVertexData(), GL_STATIC_DRAW));
 
-   m_vboMap[model->m_id] = handle;
+   vbo.modelId = model->m_id;
+}
+
+//===========================================
+// Renderer::streamVertexData
+//
+// Appends vertex data to the stream buffer and returns its offset. When the
+// buffer is full it's orphaned and writing starts again from the beginning,
+// so data still in use by the GPU is never overwritten and no
+// synchronisation is needed.
+//===========================================
+size_t Renderer::streamVertexData(const void* data, size_t size) {
+   GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, m_streamVbo));
+
+   if (m_streamOffset + size > m_streamBufferSize) {
+      while (size > m_streamBufferSize)
+         m_streamBufferSize *= 2;
+
+      GL_CHECK(m_gl.bufferData(GL_ARRAY_BUFFER, m_streamBufferSize, NULL, GL_STREAM_DRAW));
+      m_streamOffset = 0;
+   }
+
+   size_t offset = m_streamOffset;
+
+#ifdef GLEW
+   if (m_oglSupport.mapBufferRange.available) {
+      GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+
+      void* ptr = GL_CHECK(m_gl.mapBufferRange(GL_ARRAY_BUFFER, offset, size, access));
+      if (ptr == NULL)
+         throw RendererException("Error streaming vertex data; Could not map buffer", __FILE__, __LINE__);
+
+      memcpy(ptr, data, size);
+      GL_CHECK(m_gl.unmapBuffer(GL_ARRAY_BUFFER));
+   }
+   else
+#endif
+   {
+      GL_CHECK(m_gl.bufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+   }
+
+   // Keep offsets aligned for the next write
+   m_streamOffset += (size + 15) & ~static_cast<size_t>(15);
+
+   return offset;
 }
 
 //===========================================
 // Renderer::destroyVbo
 //===========================================
-void Renderer::destroyVbo(GLuint handle) {
-   if (handle != 0)
-      GL_CHECK(m_gl.deleteBuffers(1, &handle));
+void Renderer::destroyVbo(long slot) {
+   if (slot >= static_cast<long>(m_vbos.size())) return;
+
+   vbo_t& vbo = m_vbos[slot];
+
+   if (vbo.handle != 0)
+      GL_CHECK(m_gl.deleteBuffers(1, &vbo.handle));
+
+   vbo.handle = 0;
+   vbo.modelId = -1;
 }
 
 //===========================================
 // Renderer::processMessage
 //===========================================
 void Renderer::processMessage(const Message& msg) {
-   try {
-      switch (msg.type) {
-         case MSG_TEX_HANDLE_REQ: {
-            msgTexHandleReq_t dat = boost::get<msgTexHandleReq_t>(msg.data);
-            *dat.retVal = loadGLTexture(dat.texData, dat.w, dat.h);
-         }
-         break;
-         case MSG_TEX_UNLOAD_REQ: {
-            msgTexUnloadReq_t dat = boost::get<msgTexUnloadReq_t>(msg.data);
-            GL_CHECK(glDeleteTextures(1, &dat.handle));
-         }
-         break;
-         case MSG_VP_RESIZE_REQ: {
-            msgVpResizeReq_t dat = boost::get<msgVpResizeReq_t>(msg.data);
-            GL_CHECK(glViewport(0, 0, dat.w, dat.h));
-         }
-         break;
-         case MSG_CONSTRUCT_VBO: {
-            msgConstructVbo_t dat = boost::get<msgConstructVbo_t>(msg.data);
-            constructVbo(dat.model);
+   switch (msg.type) {
+      case MSG_TEX_HANDLE_REQ: {
+         const msgTexHandleReq_t& dat = msg.data.texHandleReq;
+         unique_ptr<promise<textureHandle_t> > retVal(dat.retVal);
+
+         try {
+            retVal->set_value(loadGLTexture(dat.texData, dat.w, dat.h));
          }
-         break;
-         case MSG_DESTROY_VBO: {
-            msgDestroyVbo_t dat = boost::get<msgDestroyVbo_t>(msg.data);
-            destroyVbo(dat.handle);
+         catch (...) {
+            retVal->set_exception(current_exception());
+            throw;
          }
-         break;
       }
-   }
-   catch (boost::bad_get& e) {
-      RendererException ex("Error processing request; ", __FILE__, __LINE__);
-      ex.append(e.what());
-      throw ex;
+      break;
+      case MSG_TEX_UNLOAD_REQ: {
+         textureHandle_t handle = msg.data.texUnloadReq.handle;
+         GL_CHECK(m_gl.deleteTextures(1, &handle));
+      }
+      break;
+      case MSG_VP_RESIZE_REQ: {
+         const msgVpResizeReq_t& dat = msg.data.vpResizeReq;
+         GL_CHECK(glViewport(0, 0, dat.w, dat.h));
+
+         m_redrawRequired = true;
+      }
+      break;
+      case MSG_CONSTRUCT_VBO:
+         constructVbo(msg.data.constructVbo.model);
+      break;
+      case MSG_DESTROY_VBO:
+         destroyVbo(msg.data.destroyVbo.slot);
+      break;
+      default:
+         throw RendererException("Error processing request; Unrecognised message type", __FILE__, __LINE__);
    }
 }
 
@@ -498,15 +1204,53 @@ void Renderer::computeFrameRate() {
 // Renderer::processMessages
 //===========================================
 void Renderer::processMessages() {
+   Message msg;
+
+   while (m_msgQueue.pop(msg)) {
+      processMessage(msg);
+
+      if (msg.hasPayload)
+         m_msgPayloads.release(msg.payloadEnd);
+   }
+}
+
+//===========================================
+// Renderer::discardMessages
+//
+// Empties the queue without processing it, failing any texture requests so
+// that threads waiting on them don't wait forever. Called by the render
+// thread when it terminates with an error (m_errorPending must already be
+// set), and by stop() once the render thread has exited.
+//===========================================
+void Renderer::discardMessages() {
+   // Stop any more messages being queued while we empty the queue
    lock_guard<mutex> lock(m_msgQueueMutex);
 
-   for (auto i = m_msgQueue.begin(); i != m_msgQueue.end(); ++i) {
-      processMessage(*i);
+   Message msg;
+
+   while (m_msgQueue.pop(msg)) {
+      if (msg.type == MSG_TEX_HANDLE_REQ) {
+         unique_ptr<promise<textureHandle_t> > retVal(msg.data.texHandleReq.retVal);
+
+         retVal->set_exception(make_exception_ptr(
+            RendererException("Error loading texture; Render thread has terminated", __FILE__, __LINE__)));
+      }
+
+      if (msg.hasPayload)
+         m_msgPayloads.release(msg.payloadEnd);
    }
+}
 
-   m_msgQueue.clear();
-   m_scratchSpace.clear();
-   m_msgQueueEmpty = true;
+//===========================================
+// Renderer::awaitStop
+//
+// Blocks the render thread until stop() is called.
+//===========================================
+void Renderer::awaitStop() {
+   unique_lock<mutex> lock(m_stateChangeMutex);
+
+   while (m_running)
+      m_cvRender.wait(lock);
 }
 
 //===========================================
@@ -517,67 +1261,152 @@ void Renderer::renderLoop() {
       init();
 
       while (m_running) {
+         chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+
+         bool profiling = m_profiler.isEnabled();
+         Timer timer;
+
          processMessages();
 
+         double msgTime = timer.getTime();
+
+         bool newFrame;
+         int_t maxFrameRate;
+
+         {
+            unique_lock<mutex> lock(m_stateChangeMutex);
+
+            if (m_usrReqSettings.renderOnChange && !m_redrawRequired) {
+               m_renderThreadWaiting.store(true, memory_order_relaxed);
+               atomic_thread_fence(memory_order_seq_cst);
+
+               while (m_running && m_idxLatest == m_idxRender && m_msgQueue.empty())
+                  m_cvRender.wait(lock);
+
+               m_renderThreadWaiting.store(false, memory_order_relaxed);
+
+               // Woken to process messages or to stop
+               if (m_idxLatest == m_idxRender) continue;
+            }
+
+            newFrame = m_idxLatest != m_idxRender;
+
+            if (newFrame) {
+               m_state[m_idxRender].status = renderState_t::IS_IDLE;
+               m_idxRender = m_idxLatest;
+               m_state[m_idxRender].status = renderState_t::IS_BEING_RENDERED;
+            }
+
+            maxFrameRate = m_usrReqSettings.maxFrameRate;
+         }
+
+         m_redrawRequired = false;
+
+         // Excludes any time spent waiting for a new frame
+         Timer frameTimer;
+
+         timer.reset();
+
          clear();
 
+         m_batchSpace.clear();
+
+         long drawCalls = 0;
+         long drawCallsSaved = 0;
+         long vertices = 0;
+
          for (auto i = m_state[m_idxRender].sceneGraph->begin(); i != m_state[m_idxRender].sceneGraph->end(); ++i) {
             const IModel* model = *i;
 
             if (model->getNumVertices() == 0) continue;
 
-            if (m_oglSupport.shaders.available) {
-               mode_t mode = model->getRenderMode();
-               setMode(mode);
-            }
-
-            GLuint vbo = 0;
-            if (m_oglSupport.VBOs.available) {
-               lock_guard<mutex> lock(m_vboMapMutex);
+            vertices += model->getNumVertices();
 
-               auto j = m_vboMap.find(model->m_id);
-               if (j != m_vboMap.end()) vbo = j->second;
+            if (!m_batch.empty() && !canBatch(m_batch.back(), model)) {
+               drawCallsSaved += drawBatch();
+               ++drawCalls;
             }
 
-            m_activeRenderMode->sendData(model, m_state[m_idxRender].P, vbo);
+            m_batch.push_back(model);
          }
 
-         m_swapBuffers();
+         if (!m_batch.empty()) {
+            drawCallsSaved += drawBatch();
+            ++drawCalls;
+         }
 
-         {
-            lock_guard<mutex> lock(m_stateChangeMutex);
+         double submitTime = timer.getTime();
+
+         m_drawCalls = drawCalls;
+         m_drawCallsSaved = drawCallsSaved;
+
+         m_glCallsIssued = m_gl.getCallsIssued();
+         m_glCallsElided = m_gl.getCallsElided();
 
-            m_state[m_idxRender].status = renderState_t::IS_IDLE;
-            m_idxRender = m_idxLatest;
-            m_state[m_idxRender].status = renderState_t::IS_BEING_RENDERED;
+         long programSwitches = m_gl.getProgramSwitches();
+         long textureSwitches = m_gl.getTextureSwitches();
+
+         m_gl.resetCallCounters();
+
+         timer.reset();
+         m_swapBuffers();
+         double swapTime = timer.getTime();
+
+         if (profiling) {
+            // A repeated frame involved no work on the main thread
+            RenderProfiler::frameStats_t stats = newFrame ? m_state[m_idxRender].stats : RenderProfiler::frameStats_t();
+
+            stats.frame = m_frameNumber;
+            stats.duplicate = !newFrame;
+            stats.values[RenderProfiler::MSG_TIME] = msgTime * 1000.0;
+            stats.values[RenderProfiler::SUBMIT_TIME] = submitTime * 1000.0;
+            stats.values[RenderProfiler::SWAP_TIME] = swapTime * 1000.0;
+            stats.values[RenderProfiler::FRAME_TIME] = (msgTime + frameTimer.getTime()) * 1000.0;
+            stats.values[RenderProfiler::DRAW_CALLS] = drawCalls;
+            stats.values[RenderProfiler::PROGRAM_SWITCHES] = programSwitches;
+            stats.values[RenderProfiler::TEXTURE_SWITCHES] = textureSwitches;
+            stats.values[RenderProfiler::VERTICES] = vertices;
+
+            m_profiler.record(stats);
          }
 
+         if (newFrame)
+            ++m_framesPresented;
+         else
+            ++m_framesDuplicated;
+
          ++m_frameNumber;
 #ifdef DEBUG
          computeFrameRate();
 #endif
+
+         if (maxFrameRate > 0)
+            this_thread::sleep_until(frameStart + chrono::microseconds(1000000 / maxFrameRate));
       }
    }
    catch (RendererException& e) {
       e.prepend("Exception caught in render loop; ");
       m_exception = e.constructWrapper();
       m_errorPending = true;
+      discardMessages();
 
       // Await imminent death
-      while (m_running) {}
+      awaitStop();
    }
    catch (Exception& e) {
       e.prepend("Exception caught in render loop; ");
       m_exception = exceptionWrapper_t(EXCEPTION, new Exception(e));
       m_errorPending = true;
+      discardMessages();
 
-      while (m_running) {}
+      awaitStop();
    }
    catch (...) {
       m_exception = exceptionWrapper_t(UNKNOWN_EXCEPTION, NULL);
       m_errorPending = true;
+      discardMessages();
 
-      while (m_running) {}
+      awaitStop();
    }
 }
 
@@ -23,6 +23,11 @@ namespace Dodge {
 //===========================================
 Texture::Texture(const char* file)
    : Asset(internString("Texture")),
+     m_atlasHandle(0),
+     m_atlasW(0),
+     m_atlasH(0),
+     m_atlasX(0),
+     m_atlasY(0),
      m_renderer(Renderer::getInstance()) {
 
    pngInit();
@@ -34,6 +39,11 @@ Texture::Texture(const char* file)
 //===========================================
 Texture::Texture(const XmlNode data)
    : Asset(internString("Texture")),
+     m_atlasHandle(0),
+     m_atlasW(0),
+     m_atlasH(0),
+     m_atlasX(0),
+     m_atlasY(0),
      m_renderer(Renderer::getInstance()) {
 
    try {
@@ -73,7 +83,35 @@ void Texture::constructTexture(const char* file) {
 
    PNG_CHECK(png_close_file(&m_png));
 
-   m_renderer.loadTexture(m_data, m_png.width, m_png.height, &m_handle);
+   m_handle = m_renderer.loadTextureAsync(m_data, m_png.width, m_png.height);
+}
+
+//===========================================
+// Texture::setAtlas
+//
+// The texture's own GL texture is kept, so models built before the atlas
+// continue to draw correctly until they're next updated.
+//===========================================
+void Texture::setAtlas(GLuint handle, GLint w, GLint h, GLint x, GLint y) {
+   m_atlasHandle = handle;
+   m_atlasW = w;
+   m_atlasH = h;
+   m_atlasX = x;
+   m_atlasY = y;
+}
+
+//===========================================
+// Texture::mapSection
+//
+// Converts a section of this texture to the equivalent section of the
+// texture referred to by getHandle(). As elsewhere, y is measured from the
+// bottom of the image.
+//===========================================
+Range Texture::mapSection(const Range& section) const {
+   if (m_atlasHandle == 0) return section;
+
+   Vec2f offset(static_cast<float32_t>(m_atlasX), static_cast<float32_t>(m_atlasH - m_atlasY - m_height));
+   return Range(section.getPosition() + offset, section.getSize());
 }
 
 //===========================================
@@ -106,7 +144,12 @@ void Texture::pngInit() const {
 // Texture::~Texture
 //===========================================
 Texture::~Texture() {
-   m_renderer.unloadTexture(m_handle);
+   // The data can't be freed while the render thread may still be reading it
+   try {
+      m_renderer.unloadTexture(m_handle.get());
+   }
+   catch (...) {}
+
    delete[] m_data;
 }
 
@@ -19,7 +19,8 @@ namespace Dodge {
 //===========================================
 // TexturedAlphaMode::TexturedAlphaMode
 //===========================================
-TexturedAlphaMode::TexturedAlphaMode() {
+TexturedAlphaMode::TexturedAlphaMode()
+   : m_instancedId(0) {
 
    m_id = GL_CHECK(m_gl.createProgram());
 
@@ -33,6 +34,7 @@ TexturedAlphaMode::TexturedAlphaMode() {
       "uniform vec4 uniColour;                           \n"
       "uniform mat4 mv;                                  \n"
       "uniform mat4 p;                                   \n"
+      "uniform vec4 texRect;                             \n"
 
       "varying vec4 vv4colour;                           \n"
       "varying vec2 vv2texcoord;                         \n"
@@ -46,7 +48,7 @@ TexturedAlphaMode::TexturedAlphaMode() {
       "   }                                              \n"
 
       "   gl_Position = p * mv * av4position;            \n"
-      "   vv2texcoord = av2texcoord;                     \n"
+      "   vv2texcoord = texRect.xy + av2texcoord * texRect.zw; \n"
       "}                                                 \n";
 
    RenderMode::newShaderFromSource(vertShader, GL_VERTEX_SHADER, m_id);
@@ -66,13 +68,6 @@ TexturedAlphaMode::TexturedAlphaMode() {
    RenderMode::newShaderFromSource(fragShader, GL_FRAGMENT_SHADER, m_id);
 
    GL_CHECK(m_gl.linkProgram(m_id));
-}
-
-//===========================================
-// TexturedAlphaMode::setActive
-//===========================================
-void TexturedAlphaMode::setActive() {
-   GL_CHECK(m_gl.useProgram(m_id));
 
    m_locPosition = GL_CHECK(m_gl.getAttribLocation(m_id, "av4position"));
    m_locColour = GL_CHECK(m_gl.getAttribLocation(m_id, "av4colour"));
@@ -82,13 +77,88 @@ void TexturedAlphaMode::setActive() {
    m_locUniColour = GL_CHECK(m_gl.getUniformLocation(m_id, "uniColour"));
    m_locMV = GL_CHECK(m_gl.getUniformLocation(m_id, "mv"));
    m_locP = GL_CHECK(m_gl.getUniformLocation(m_id, "p"));
+   m_locTexRect = GL_CHECK(m_gl.getUniformLocation(m_id, "texRect"));
+
+#ifdef GLEW
+   if (m_gl.getSupportedFeatures().instancing.available)
+      constructInstancedProgram();
+#endif
+}
+
+//===========================================
+// TexturedAlphaMode::constructInstancedProgram
+//
+// As the main program, but with the matrix, colour and texture rect
+// supplied per instance.
+//===========================================
+void TexturedAlphaMode::constructInstancedProgram() {
+   m_instancedId = GL_CHECK(m_gl.createProgram());
+
+   const char* vertShader[1] = { NULL };
+   vertShader[0] =
+      "attribute vec4 av4position;                       \n"
+      "attribute vec2 av2texcoord;                       \n"
+      "attribute vec4 av4mv0;                            \n"
+      "attribute vec4 av4mv1;                            \n"
+      "attribute vec4 av4mv2;                            \n"
+      "attribute vec4 av4mv3;                            \n"
+      "attribute vec4 av4colour;                         \n"
+      "attribute vec4 av4texRect;                        \n"
+
+      "uniform mat4 p;                                   \n"
+
+      "varying vec4 vv4colour;                           \n"
+      "varying vec2 vv2texcoord;                         \n"
+
+      "void main() {                                     \n"
+      "   mat4 mv = mat4(av4mv0, av4mv1, av4mv2, av4mv3);\n"
+
+      "   vv4colour = av4colour;                         \n"
+      "   gl_Position = p * mv * av4position;            \n"
+      "   vv2texcoord = av4texRect.xy + av2texcoord * av4texRect.zw; \n"
+      "}                                                 \n";
+
+   RenderMode::newShaderFromSource(vertShader, GL_VERTEX_SHADER, m_instancedId);
+
+   const char* fragShader[1] = { NULL };
+   fragShader[0] =
+      "varying vec4 vv4colour;                           \n"
+      "varying vec2 vv2texcoord;                         \n"
+
+      "uniform sampler2D stexture;                       \n"
+
+      "void main() {                                     \n"
+      "   vec4 tex = texture2D(stexture, vv2texcoord);   \n"
+      "   gl_FragColor = vv4colour * tex;                \n"
+      "}                                                 \n";
+
+   RenderMode::newShaderFromSource(fragShader, GL_FRAGMENT_SHADER, m_instancedId);
+
+   GL_CHECK(m_gl.linkProgram(m_instancedId));
+
+   m_locInstPosition = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4position"));
+   m_locInstTexCoord = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av2texcoord"));
+   m_locInstMV[0] = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4mv0"));
+   m_locInstMV[1] = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4mv1"));
+   m_locInstMV[2] = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4mv2"));
+   m_locInstMV[3] = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4mv3"));
+   m_locInstColour = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4colour"));
+   m_locInstTexRect = GL_CHECK(m_gl.getAttribLocation(m_instancedId, "av4texRect"));
+   m_locInstP = GL_CHECK(m_gl.getUniformLocation(m_instancedId, "p"));
+}
+
+//===========================================
+// TexturedAlphaMode::setActive
+//===========================================
+void TexturedAlphaMode::setActive() {
+   GL_CHECK(m_gl.useProgram(m_id));
 
    GL_CHECK(m_gl.enableVertexAttribArray(m_locPosition));
    GL_CHECK(m_gl.enableVertexAttribArray(m_locColour));
    GL_CHECK(m_gl.enableVertexAttribArray(m_locTexCoord));
 
-   GL_CHECK(glEnable(GL_BLEND));
-   GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+   GL_CHECK(m_gl.enable(GL_BLEND));
+   GL_CHECK(m_gl.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 }
 
 //===========================================
@@ -107,7 +177,7 @@ bool TexturedAlphaMode::isSupported(const IModel* model) const {
 //===========================================
 // TexturedAlphaMode::sendData
 //===========================================
-void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo) {
+void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat, GLuint vbo, size_t vboOffset) {
    static long vvvttcccc = internString("vvvttcccc");
 
    if (!isSupported(model))
@@ -118,9 +188,12 @@ void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat
    GL_CHECK(m_gl.uniformMatrix4fv(m_locMV, 1, GL_FALSE, model_getMatrix(*model)));
    GL_CHECK(m_gl.uniformMatrix4fv(m_locP, 1, GL_FALSE, projMat.data()));
 
+   const Renderer::texCoordElement_t* rect = model->getTextureRect();
+   GL_CHECK(m_gl.uniform4f(m_locTexRect, rect[0], rect[1], rect[2], rect[3]));
+
    if (model->getPrimitiveType() == Renderer::LINES) {
       if (model->getLineWidth() != 0)
-         GL_CHECK(glLineWidth(static_cast<GLfloat>(model->getLineWidth())));
+         GL_CHECK(m_gl.lineWidth(static_cast<GLfloat>(model->getLineWidth())));
    }
 
    // If model contains per-vertex colour data
@@ -136,7 +209,7 @@ void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat
       GL_CHECK(m_gl.uniform4f(m_locUniColour, colour.r, colour.g, colour.b, colour.a));
    }
 
-   GL_CHECK(glBindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
+   GL_CHECK(m_gl.bindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
 
    const vvvttcccc_t* verts = reinterpret_cast<const vvvttcccc_t*>(model_getVertexData(*model));
    GLint stride = vertLayout == vvvttcccc ? sizeof(vvvttcccc_t) : sizeof(vvvtt_t);
@@ -154,7 +227,7 @@ void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat
    else {
       GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, vbo));
 
-      GLuint offset = 0;
+      size_t offset = vboOffset;
 
       GL_CHECK(m_gl.vertexAttribPointer(m_locPosition, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offset)));
       offset += 3 * sizeof(GLfloat);
@@ -169,5 +242,79 @@ void TexturedAlphaMode::sendData(const IModel* model, const matrix44f_c& projMat
    GL_CHECK(glDrawArrays(primitiveToGLType(model->getPrimitiveType()), 0, model->getNumVertices()));
 }
 
+//===========================================
+// TexturedAlphaMode::canDrawInstanced
+//===========================================
+bool TexturedAlphaMode::canDrawInstanced(const IModel* model) const {
+#ifdef GLEW
+   static long vvvtt = internString("vvvtt");
+
+   return m_instancedId != 0 && model->getVertexLayout() == vvvtt;
+#else
+   return false;
+#endif
+}
+
+//===========================================
+// TexturedAlphaMode::sendInstances
+//===========================================
+bool TexturedAlphaMode::sendInstances(const IModel* model, const matrix44f_c& projMat, GLuint vbo, size_t vboOffset,
+   uint_t numInstances, GLuint instanceVbo, size_t instanceOffset) {
+
+#ifdef GLEW
+   static long vvvtt = internString("vvvtt");
+
+   if (m_instancedId == 0 || vbo == 0 || instanceVbo == 0) return false;
+   if (model->getVertexLayout() != vvvtt) return false;
+
+   GL_CHECK(m_gl.useProgram(m_instancedId));
+   GL_CHECK(m_gl.uniformMatrix4fv(m_locInstP, 1, GL_FALSE, projMat.data()));
+
+   GL_CHECK(m_gl.bindTexture(GL_TEXTURE_2D, model->getTextureHandle()));
+
+   GLint stride = sizeof(vvvtt_t);
+
+   GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, vbo));
+
+   GL_CHECK(m_gl.enableVertexAttribArray(m_locInstPosition));
+   GL_CHECK(m_gl.vertexAttribPointer(m_locInstPosition, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(vboOffset)));
+
+   GL_CHECK(m_gl.enableVertexAttribArray(m_locInstTexCoord));
+   GL_CHECK(m_gl.vertexAttribPointer(m_locInstTexCoord, 2, GL_FLOAT, GL_FALSE, stride,
+      reinterpret_cast<const void*>(vboOffset + 3 * sizeof(GLfloat))));
+
+   GL_CHECK(m_gl.bindBuffer(GL_ARRAY_BUFFER, instanceVbo));
+
+   stride = sizeof(modelInstance_t);
+
+   GLint locs[] = {
+      m_locInstMV[0], m_locInstMV[1], m_locInstMV[2], m_locInstMV[3], m_locInstColour, m_locInstTexRect
+   };
+
+   // Each attribute is 4 floats, laid out consecutively in modelInstance_t
+   for (uint_t i = 0; i < 6; ++i) {
+      size_t offset = instanceOffset + i * 4 * sizeof(GLfloat);
+
+      GL_CHECK(m_gl.enableVertexAttribArray(locs[i]));
+      GL_CHECK(m_gl.vertexAttribPointer(locs[i], 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offset)));
+      GL_CHECK(m_gl.vertexAttribDivisor(locs[i], 1));
+   }
+
+   GL_CHECK(m_gl.drawArraysInstanced(primitiveToGLType(model->getPrimitiveType()), 0, model->getNumVertices(), numInstances));
+
+   for (uint_t i = 0; i < 6; ++i) {
+      GL_CHECK(m_gl.vertexAttribDivisor(locs[i], 0));
+      GL_CHECK(m_gl.disableVertexAttribArray(locs[i]));
+   }
+
+   // Restore the main program
+   setActive();
+
+   return true;
+#else
+   return false;
+#endif
+}
+
 
 }
@@ -6,6 +6,8 @@
 #include "TestCase3.hpp"
 #include "TestCase4.hpp"
 #include "TestCase5.hpp"
+#include "TestCase6.hpp"
+#include "TestCase7.hpp"
 
 
 using namespace std;
@@ -93,6 +95,8 @@ void Test::run() {
    m_tests.push_back(pTestCase_t(new TestCase3));
    m_tests.push_back(pTestCase_t(new TestCase4));
    m_tests.push_back(pTestCase_t(new TestCase5));
+   m_tests.push_back(pTestCase_t(new TestCase6));
+   m_tests.push_back(pTestCase_t(new TestCase7));
 
    m_active = 0;
    m_tests[m_active]->setup();
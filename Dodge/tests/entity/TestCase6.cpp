@@ -0,0 +1,61 @@
+#include <sstream>
+#include "TestCase6.hpp"
+
+
+using namespace std;
+using namespace Dodge;
+
+
+// Tests function Entity::translateMany()
+
+
+void TestCase6::setup() {
+   m_frame = 0;
+
+   for (int i = 0; i < 10; ++i) {
+      for (int j = 0; j < 10; ++j) {
+         stringstream name;
+         name << "Small" << i << "_" << j;
+
+         m_entities.push_back(pEntity_t(new Entity(internString(name.str()), internString("Polygon"))));
+         m_entities.back()->setShape(unique_ptr<Shape>(new Quad(Vec2f(0.02, 0.02))));
+         m_entities.back()->setFillColour(Colour(0.1f * i, 0.1f * j, 0.5, 1.0));
+         m_entities.back()->setLineColour(Colour(0.0, 1.0, 0.0, 1.0));
+         m_entities.back()->setLineWidth(1);
+         m_entities.back()->setTranslation(0.1 + 0.04 * i, 0.1 + 0.04 * j);
+         m_entities.back()->setZ(1);
+         m_entities.back()->addToWorld();
+
+         // Alternate rows move in opposite directions
+         m_deltas.push_back(Vec2f(j % 2 ? 0.002f : -0.002f, 0.f));
+      }
+   }
+}
+
+void TestCase6::update() {
+   // Whole formation drifts upwards and back
+   Entity::translateMany(m_entities, Vec2f(0.f, m_frame < 100 ? 0.001f : -0.001f));
+   Entity::translateMany(m_entities, m_deltas);
+
+   if (++m_frame == 200) {
+      m_frame = 0;
+
+      for (unsigned int i = 0; i < m_deltas.size(); ++i)
+         m_deltas[i] = m_deltas[i] * -1.f;
+   }
+
+   for (unsigned int i = 0; i < m_entities.size(); ++i)
+      m_entities[i]->update();
+
+   for (unsigned int i = 0; i < m_entities.size(); ++i)
+      m_entities[i]->draw();
+}
+
+void TestCase6::terminate() {
+   m_entities.clear();
+   m_deltas.clear();
+}
+
+TestCase6::~TestCase6() {
+   terminate();
+}
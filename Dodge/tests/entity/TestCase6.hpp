@@ -0,0 +1,25 @@
+#ifndef __TEST_CASE_6_HPP__
+#define __TEST_CASE_6_HPP__
+
+
+#include <vector>
+#include <dodge/dodge.hpp>
+#include "TestCase.hpp"
+
+
+class TestCase6 : public TestCase {
+   public:
+      virtual void setup();
+      virtual void update();
+      virtual void terminate();
+
+      virtual ~TestCase6();
+
+   private:
+      std::vector<Dodge::pEntity_t> m_entities;
+      std::vector<Dodge::Vec2f> m_deltas;
+      int m_frame;
+};
+
+
+#endif
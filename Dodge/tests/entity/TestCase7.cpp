@@ -0,0 +1,51 @@
+#include <iostream>
+#include "TestCase7.hpp"
+
+
+using namespace std;
+using namespace Dodge;
+
+
+// Tests stale handle detection in EntityRegistry
+
+
+void TestCase7::setup() {
+   EntityRegistry registry;
+   bool pass = true;
+
+   pEntity_t entity(new Entity(internString("Entity1"), internString("Polygon")));
+   EntityHandle oldHandle = entity->getHandle();
+
+   pass = pass && registry.getEntity(oldHandle) == entity.get();
+
+   // Destroying the entity should invalidate its handle
+   entity.reset();
+   pass = pass && !registry.isValid(oldHandle) && registry.getEntity(oldHandle) == NULL;
+
+   // The freed slot is reused, but with a new generation
+   m_entity = pEntity_t(new Entity(internString("Entity2"), internString("Polygon")));
+   EntityHandle newHandle = m_entity->getHandle();
+
+   pass = pass && newHandle.index == oldHandle.index && newHandle.generation != oldHandle.generation;
+   pass = pass && !registry.isValid(oldHandle) && registry.getEntity(newHandle) == m_entity.get();
+
+   m_entity->setShape(unique_ptr<Shape>(new Quad(Vec2f(0.2, 0.2))));
+   m_entity->setFillColour(pass ? Colour(0.0, 1.0, 0.0, 1.0) : Colour(1.0, 0.0, 0.0, 1.0));
+   m_entity->setTranslation(0.3, 0.3);
+   m_entity->setZ(1);
+
+   cout << "TEST: EntityRegistry\n";
+   cout << "RESULT: " << (pass ? "PASS" : "FAIL") << "\n";
+}
+
+void TestCase7::update() {
+   m_entity->draw();
+}
+
+void TestCase7::terminate() {
+   m_entity.reset();
+}
+
+TestCase7::~TestCase7() {
+   terminate();
+}
@@ -0,0 +1,22 @@
+#ifndef __TEST_CASE_7_HPP__
+#define __TEST_CASE_7_HPP__
+
+
+#include <dodge/dodge.hpp>
+#include "TestCase.hpp"
+
+
+class TestCase7 : public TestCase {
+   public:
+      virtual void setup();
+      virtual void update();
+      virtual void terminate();
+
+      virtual ~TestCase7();
+
+   private:
+      Dodge::pEntity_t m_entity;
+};
+
+
+#endif
@@ -1,6 +1,7 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <cmath>
 #include <dodge/dodge.hpp>
 #include "Test.hpp"
 
@@ -9,6 +10,79 @@ using namespace std;
 using namespace Dodge;
 
 
+static float32_t polygonArea(const vector<Vec2f>& poly) {
+   float32_t area = 0.f;
+   for (uint_t i = 0; i < poly.size(); ++i) {
+      const Vec2f& a = poly[i];
+      const Vec2f& b = poly[(i + 1) % poly.size()];
+
+      area += a.x * b.y - b.x * a.y;
+   }
+
+   return fabs(area) / 2.f;
+}
+
+// Returns -1 if any triangle isn't anti-clockwise
+static float32_t trianglesArea(const vector<Vec2f>& poly, const vector<int>& triangles) {
+   float32_t area = 0.f;
+   for (uint_t i = 0; i + 2 < triangles.size(); i += 3) {
+      const Vec2f& a = poly[triangles[i]];
+      const Vec2f& b = poly[triangles[i + 1]];
+      const Vec2f& c = poly[triangles[i + 2]];
+
+      float32_t cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      if (cross <= 0.f) return -1.f;
+
+      area += cross / 2.f;
+   }
+
+   return area;
+}
+
+static bool testTriangulate(const string& name, const vector<Vec2f>& poly, uint_t expectedTriangles, bool verbose) {
+   vector<int> triangles;
+   Math::triangulate(poly, triangles);
+
+   bool pass = triangles.size() == expectedTriangles * 3;
+
+   for (uint_t i = 0; i < triangles.size(); ++i)
+      if (triangles[i] < 0 || triangles[i] >= static_cast<int>(poly.size())) pass = false;
+
+   float32_t expectedArea = polygonArea(poly);
+   float32_t area = trianglesArea(poly, triangles);
+
+   if (fabs(area - expectedArea) > 0.0001f) pass = false;
+
+   if (verbose || !pass) {
+      cout << name << ": " << triangles.size() / 3 << " triangles (expected " << expectedTriangles << "), area "
+         << area << " (expected " << expectedArea << ") " << (pass ? "ok" : "FAILED") << "\n";
+   }
+
+   return pass;
+}
+
+static bool testTriangulateFan(const string& name, const vector<Vec2f>& poly, bool verbose) {
+   vector<int> triangles;
+   Math::triangulate(poly, triangles);
+
+   // Every vertex should still be covered by the fallback fan
+   vector<bool> used(poly.size(), false);
+   for (uint_t i = 0; i < triangles.size(); ++i) {
+      if (triangles[i] >= 0 && triangles[i] < static_cast<int>(poly.size()))
+         used[triangles[i]] = true;
+   }
+
+   bool pass = triangles.size() == (poly.size() - 2) * 3;
+
+   for (uint_t i = 0; i < used.size(); ++i)
+      if (!used[i]) pass = false;
+
+   if (verbose || !pass)
+      cout << name << ": " << triangles.size() / 3 << " triangles (expected " << poly.size() - 2 << ") " << (pass ? "ok" : "FAILED") << "\n";
+
+   return pass;
+}
+
 void Test::run(bool verbose) {
    bool pass = true;
 
@@ -25,5 +99,55 @@ void Test::run(bool verbose) {
 
    Polygon poly3 = poly2;
 
+   vector<Vec2f> lShape;
+   lShape.push_back(Vec2f(0, 0));
+   lShape.push_back(Vec2f(2, 0));
+   lShape.push_back(Vec2f(2, 1));
+   lShape.push_back(Vec2f(1, 1));
+   lShape.push_back(Vec2f(1, 2));
+   lShape.push_back(Vec2f(0, 2));
+
+   if (!testTriangulate("Concave (L)", lShape, 4, verbose)) pass = false;
+
+   // Teeth of differing heights, so that clipping never leaves three vertices in a line
+   vector<Vec2f> comb;
+   comb.push_back(Vec2f(0, 0));
+   comb.push_back(Vec2f(5, 0));
+   comb.push_back(Vec2f(5, 3));
+   comb.push_back(Vec2f(4, 3));
+   comb.push_back(Vec2f(4, 1));
+   comb.push_back(Vec2f(3, 1.5));
+   comb.push_back(Vec2f(3, 3.5));
+   comb.push_back(Vec2f(2, 3.5));
+   comb.push_back(Vec2f(2, 1.25));
+   comb.push_back(Vec2f(1, 1.75));
+   comb.push_back(Vec2f(1, 4));
+   comb.push_back(Vec2f(0, 4));
+
+   if (!testTriangulate("Concave (comb)", comb, 10, verbose)) pass = false;
+
+   vector<Vec2f> clockwise(comb.rbegin(), comb.rend());
+
+   if (!testTriangulate("Clockwise", clockwise, 10, verbose)) pass = false;
+
+   // The vertex midway along the bottom edge is dropped rather than producing a zero-area triangle
+   vector<Vec2f> collinear;
+   collinear.push_back(Vec2f(1, 0));
+   collinear.push_back(Vec2f(2, 0));
+   collinear.push_back(Vec2f(2, 2));
+   collinear.push_back(Vec2f(0, 2));
+   collinear.push_back(Vec2f(0, 0));
+
+   if (!testTriangulate("Collinear", collinear, 2, verbose)) pass = false;
+
+   // A pentagram, whose ears run out before it's fully clipped, leaving the rest to be fanned
+   vector<Vec2f> star;
+   for (int i = 0; i < 5; ++i) {
+      float32_t a = static_cast<float32_t>(i) * 4.f * PI / 5.f;
+      star.push_back(Vec2f(cos(a), sin(a)));
+   }
+
+   if (!testTriangulateFan("Self-intersecting", star, verbose)) pass = false;
+
    cout << "RESULT: " << (pass ? "PASS" : "FAIL") << "\n";
 }
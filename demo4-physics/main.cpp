@@ -138,6 +138,16 @@ void entityTranslationHandler(EEvent* ev) {
    }
 }
 
+void entityBatchTranslationHandler(EEvent* ev) {
+   EEntityBatchTranslation* event = static_cast<EEntityBatchTranslation*>(ev);
+
+   for (uint_t i = 0; i < event->entries.size(); ++i) {
+      if (event->entries[i].entity->getTranslation_abs().y < -1.f) {
+         eraseEntity(event->entries[i].entity);
+      }
+   }
+}
+
 int main(int argc, char** argv) {
    if (argc > 0) {
       for (int i = 0; i < argc; ++i) {
@@ -166,6 +176,7 @@ int main(int argc, char** argv) {
    renderer.attachCamera(camera);
 
    eventManager.registerCallback(internString("entityTranslation"), Functor<void, TYPELIST_1(EEvent*)>(entityTranslationHandler));
+   eventManager.registerCallback(internString("entityBatchTranslation"), Functor<void, TYPELIST_1(EEvent*)>(entityBatchTranslationHandler));
 
    worldSpace.init(unique_ptr<Quadtree<pEntity_t> >(new Quadtree<pEntity_t>(1, Range(0.f, 0.f, 64.f / 48.f, 1.f))));
 
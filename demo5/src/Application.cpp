@@ -368,6 +368,10 @@ void Application::onWindowResize(int w, int h) {
 // Application::draw
 //===========================================
 void Application::draw() const {
+   // Static map assets are baked into per-segment geometry, which the entities
+   // no longer draw themselves
+   m_mapLoader.draw();
+
    vector<pEntity_t> visibleEnts;
 
    m_worldSpace.getEntities(m_viewArea, visibleEnts);
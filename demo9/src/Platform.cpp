@@ -1,6 +1,7 @@
 #include <memory>
 #include <dodge/math/math.hpp>
 #include <dodge/EEntityCollision.hpp>
+#include <dodge/EntityRegistry.hpp>
 #include "Platform.hpp"
 
 
@@ -71,20 +72,23 @@ void Platform::onEvent(const EEvent* event) {
    // We're in the middle of Box2D's step() function, so
    // can't move anything yet.
 
-   assert(e->entityA);
+   assert(!e->entityA.isNull());
 
-   assert(e->entityA == getSharedPtr());
-   assert(e->entityB != getSharedPtr());
+   assert(e->entityA == getHandle());
+   assert(e->entityB != getHandle());
 
-   assert(e->entityB.use_count() > 1);
+   EntityRegistry registry;
+   pEntity_t entityB = registry.getSharedPtr(e->entityB);
+
+   assert(entityB);
 
    if (e->incoming) {
-      if (m_contacts.find(e->entityB) == m_contacts.end()) {
-         m_pendingAddition.insert(e->entityB);
+      if (m_contacts.find(entityB) == m_contacts.end()) {
+         m_pendingAddition.insert(entityB);
       }
    }
    else {
-      m_pendingRemoval.insert(e->entityB);
+      m_pendingRemoval.insert(entityB);
    }
 }
 